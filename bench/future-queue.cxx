@@ -0,0 +1,154 @@
+#include <devastator/diagnostic.hxx>
+#include <devastator/intrusive_calendar_queue.hxx>
+#include <devastator/intrusive_min_heap.hxx>
+#include <devastator/intrusive_soa_heap.hxx>
+#include <devastator/os_env.hxx>
+#include <devastator/utility.hxx>
+
+#include "util/perf_counter.hxx"
+#include "util/report.hxx"
+#include "util/timer.hxx"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+// Compares the per-cd pending event queues on a hold model: pop the least
+// event and reinsert it later, every eighth op also erasing a random queued
+// event and reinserting it (as annihilation and rollback do). The events are
+// sized and scattered like real ones so queues writing back into them each
+// time they move an entry pay for it in cache misses.
+
+struct rng_state {
+  uint64_t a, b;
+
+  rng_state(int64_t seed=0) {
+    a = 0x1234567812345678ull*(1+seed);
+    b = 0xdeadbeefdeadbeefull*(10+seed);
+  }
+
+  uint64_t operator()() {
+    uint64_t x = a;
+    uint64_t y = b;
+    a = y;
+    x ^= x << 23;
+    b = x ^ y ^ (x >> 17) ^ (y >> 26);
+    return b + y;
+  }
+};
+
+// creator line, target line, payload
+struct alignas(64) fake_event {
+  uint64_t time, subtime;
+  int32_t future_ix;
+  char rest[192 - 2*sizeof(uint64_t) - sizeof(int32_t)];
+};
+
+// mirrors `pdes::detail::stamped_event`
+struct stamped {
+  fake_event *e;
+  uint64_t time, subtime;
+
+  static int32_t& future_ix_of(stamped se) { return se.e->future_ix; }
+  static uint64_t time_of(stamped se) { return se.time; }
+
+  struct stamp {
+    uint64_t time, subtime;
+    friend bool operator<(stamp a, stamp b) {
+      bool ans = a.subtime < b.subtime;
+      ans &= a.time == b.time;
+      ans |= a.time < b.time;
+      return ans;
+    }
+  };
+  static stamp stamp_of(stamped se) { return {se.time, se.subtime}; }
+
+  friend bool operator<(stamped a, stamped b) {
+    return stamp_of(a) < stamp_of(b);
+  }
+  friend bool operator<=(stamped a, stamped b) {
+    return !(b < a);
+  }
+};
+
+using heap_queue = deva::intrusive_min_heap<
+  stamped, stamped, stamped::future_ix_of, deva::identity<stamped>>;
+using calendar_queue = deva::intrusive_calendar_queue<
+  stamped, stamped, stamped::future_ix_of, deva::identity<stamped>, stamped::time_of>;
+using soa_queue = deva::intrusive_soa_heap<
+  stamped, stamped::stamp, stamped::future_ix_of, stamped::stamp_of>;
+
+template<typename Queue>
+void run(const char *name, int queue_n, int64_t op_n) {
+  // events strewn over a larger arena in random order
+  int arena_n = 4*queue_n;
+  std::unique_ptr<fake_event[]> arena(new fake_event[arena_n]);
+  std::vector<fake_event*> evs(arena_n);
+  for(int i=0; i < arena_n; i++)
+    evs[i] = &arena[i];
+
+  rng_state rng(queue_n);
+  for(int i=arena_n-1; i > 0; i--)
+    std::swap(evs[i], evs[rng() % (i+1)]);
+
+  Queue q;
+  uint64_t subtime = 0;
+  for(int i=0; i < queue_n; i++) {
+    fake_event *e = evs[i];
+    e->time = rng() % (1<<20);
+    e->subtime = subtime++;
+    q.insert({e, e->time, e->subtime});
+  }
+
+  deva::bench::perf_counter misses(deva::bench::perf_counter::cache_misses);
+  deva::bench::perf_counter l1_misses(deva::bench::perf_counter::l1d_read_misses);
+  misses.start();
+  l1_misses.start();
+  deva::bench::timer begun;
+
+  for(int64_t op=0; op < op_n; op++) {
+    stamped se = q.pop_least();
+    se.time += 1 + rng() % (1<<16);
+    se.subtime = subtime++;
+    se.e->time = se.time;
+    se.e->subtime = se.subtime;
+    q.insert(se);
+
+    if((op & 7) == 0) {
+      stamped x = q.at(int(rng() % q.size()));
+      q.erase(x);
+      x.subtime = subtime++;
+      x.e->subtime = x.subtime;
+      q.insert(x);
+    }
+  }
+
+  double secs = begun.elapsed();
+  int64_t miss_n = misses.stop();
+  int64_t l1_miss_n = l1_misses.stop();
+
+  deva::bench::report rep(__FILE__);
+  rep.emit(
+    deva::datarow::x("queue", name) &
+    deva::datarow::x("queue_n", queue_n) &
+    deva::datarow::y("ns_per_op", 1e9*secs/op_n) &
+    deva::datarow::y("cache_miss_per_op", miss_n < 0 ? -1.0 : double(miss_n)/op_n) &
+    deva::datarow::y("l1d_miss_per_op", l1_miss_n < 0 ? -1.0 : double(l1_miss_n)/op_n)
+  );
+}
+
+int main() {
+  int64_t op_n = deva::os_env<int64_t>("op_n", 1<<22);
+
+  for(int queue_n = deva::os_env<int>("queue_n_lo", 1<<8);
+      queue_n <= deva::os_env<int>("queue_n_hi", 1<<16);
+      queue_n *= 4) {
+    run<heap_queue>("heap", queue_n, op_n);
+    run<calendar_queue>("calendar", queue_n, op_n);
+    run<soa_queue>("soa", queue_n, op_n);
+  }
+  return 0;
+}
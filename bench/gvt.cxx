@@ -0,0 +1,71 @@
+#include <devastator/diagnostic.hxx>
+#include <devastator/world.hxx>
+#include <devastator/gvt.hxx>
+#include <devastator/os_env.hxx>
+
+#include "util/report.hxx"
+#include "util/timer.hxx"
+
+#include <cstdint>
+
+using namespace std;
+
+namespace gvt = deva::gvt;
+
+using deva::rank_n;
+
+// Measures back to back gvt collectives with no simulation traffic, so every
+// round is a quiesced epoch and its cost is the reduction alone.
+int main() {
+  deva::run([]() {
+    double cutoff = deva::os_env<double>("wall_secs", 2);
+    uint64_t lvt = 1000 + deva::rank_me();
+
+    gvt::init(0, {0, 0});
+    gvt::coll_begin(lvt, {0, 0});
+
+    deva::bench::timer begun;
+    bool terminating = false;
+    int64_t round_n = 0;
+    int skips = 0;
+
+    while(true) {
+      deva::progress();
+      gvt::advance();
+
+      if(gvt::coll_ended()) {
+        DEVA_ASSERT_ALWAYS(gvt::coll_was_epoch());
+        round_n += 1;
+
+        if(++skips == 100) {
+          skips = 0;
+          terminating = begun.elapsed() >= cutoff;
+        }
+
+        // everyone agrees to stop on the round a rank reports in, rounds
+        // still in flight are abandoned
+        if(gvt::coll_reducibles().sum1 != 0)
+          break;
+      }
+
+      if(gvt::coll_can_begin())
+        gvt::coll_begin(lvt, {terminating ? 1u : 0u, 0});
+    }
+
+    double wall_secs = deva::reduce_max(begun.elapsed());
+    round_n = deva::reduce_max(round_n);
+
+    if(deva::rank_me() == 0) {
+      deva::bench::report rep(__FILE__);
+      rep.emit(
+        deva::datarow::x("rank_n", rank_n) &
+        deva::datarow::x("process_n", deva::process_n) &
+        deva::datarow::x("pgvt", DEVA_GVT_MATTERN ? "mattern" : "epoch") &
+        deva::datarow::x("gvt_radix", gvt::radix) &
+        deva::datarow::x("gvt_pipeline", gvt::pipeline) &
+        deva::datarow::y("rounds_per_sec", round_n/wall_secs)
+      );
+    }
+  });
+  return 0;
+}
@@ -0,0 +1,101 @@
+#include <devastator/intrusive_dary_heap.hxx>
+#include <devastator/intrusive_min_heap.hxx>
+#include <devastator/os_env.hxx>
+
+#include "util/report.hxx"
+#include "util/timer.hxx"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+// Compares the rank wide heaps of cds (keyed by a `uint64_t` time) as a
+// binary heap against `d`-ary heaps: pop the least, advance its key and
+// reinsert, every fourth op also moving a random item's key either way (as
+// rollbacks and arrivals do to `cds_by_now`).
+
+struct rng_state {
+  uint64_t a, b;
+
+  rng_state(int64_t seed=0) {
+    a = 0x1234567812345678ull*(1+seed);
+    b = 0xdeadbeefdeadbeefull*(10+seed);
+  }
+
+  uint64_t operator()() {
+    uint64_t x = a;
+    uint64_t y = b;
+    a = y;
+    x ^= x << 23;
+    b = x ^ y ^ (x >> 17) ^ (y >> 26);
+    return b + y;
+  }
+};
+
+struct item {
+  uint64_t key;
+  int ix;
+
+  static int& ix_of(item *x) { return x->ix; }
+  static uint64_t key_of(item *x) { return x->key; }
+};
+
+using binary_heap = deva::intrusive_min_heap<item*, uint64_t, item::ix_of, item::key_of>;
+template<int d>
+using dary_heap = deva::intrusive_dary_heap<item*, uint64_t, item::ix_of, item::key_of, d>;
+
+template<typename Heap>
+void run(const char *name, int arity, int heap_n, int64_t op_n) {
+  std::unique_ptr<item[]> items(new item[heap_n]);
+  rng_state rng(heap_n);
+
+  Heap h;
+  for(int i=0; i < heap_n; i++) {
+    items[i].key = rng() % (1<<20);
+    h.insert(&items[i]);
+  }
+
+  deva::bench::timer begun;
+
+  for(int64_t op=0; op < op_n; op++) {
+    item *x = h.pop_least();
+    x->key += 1 + rng() % (1<<16);
+    h.insert(x);
+
+    if((op & 3) == 0) {
+      item *y = &items[rng() % heap_n];
+      uint64_t key0 = y->key;
+      y->key = h.least_key() + rng() % (1<<17);
+      if(y->key < key0)
+        h.decreased(y);
+      else
+        h.increased(y);
+    }
+  }
+
+  double secs = begun.elapsed();
+
+  deva::bench::report rep(__FILE__);
+  rep.emit(
+    deva::datarow::x("heap", name) &
+    deva::datarow::x("arity", arity) &
+    deva::datarow::x("heap_n", heap_n) &
+    deva::datarow::y("ns_per_op", 1e9*secs/op_n)
+  );
+}
+
+int main() {
+  int64_t op_n = deva::os_env<int64_t>("op_n", 1<<22);
+
+  for(int heap_n = deva::os_env<int>("heap_n_lo", 1<<6);
+      heap_n <= deva::os_env<int>("heap_n_hi", 1<<16);
+      heap_n *= 4) {
+    run<binary_heap>("binary", 2, heap_n, op_n);
+    run<dary_heap<4>>("dary", 4, heap_n, op_n);
+    run<dary_heap<8>>("dary", 8, heap_n, op_n);
+  }
+  return 0;
+}
@@ -6,6 +6,7 @@
 #include "util/report.hxx"
 #include "util/timer.hxx"
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
 #include <cstdint>
@@ -64,6 +65,7 @@ double peer_stddev;
 thread_local unique_ptr<rng_state[]> state_cur;
 
 thread_local deva::bench::timer begun;
+thread_local int skips;
 double cutoff;
 
 struct bounce {
@@ -92,7 +94,6 @@ struct bounce {
     rng_state &rng = state_cur[cd];
     rng_state state_prev = rng;
 
-    static __thread int skips = 0;
     if(skips < 0)
       return reverse{state_prev};
     else if(++skips == 100) {
@@ -130,6 +131,9 @@ struct bounce {
 
 int main() {
   double duration;
+
+  // commit_offload=1 runs the (empty) commit()s on the committer thread
+  pdes::commit_offload = deva::os_env<bool>("commit_offload", false);
   
   auto doit = [&]() {
     if(deva::rank_me_local() == 0) {
@@ -159,6 +163,7 @@ int main() {
     }
 
     begun.reset();
+    skips = 0;
     
     pdes::drain();
     
@@ -174,14 +179,39 @@ int main() {
         deva::datarow::x("lp_per_rank", lp_per_rank) &
         deva::datarow::x("ray_per_lp", ray_per_lp) &
         deva::datarow::x("peer_stddev", peer_stddev) &
+        deva::datarow::x("pfuture", DEVA_PDES_FUTURE_CALENDAR ? "calendar" : DEVA_PDES_FUTURE_SOA ? "soa" : "heap") &
+        deva::datarow::x("pgvt", DEVA_GVT_MATTERN ? "mattern" : "epoch") &
+        deva::datarow::x("pevpool", DEVA_PDES_EVENT_POOL) &
+        deva::datarow::x("pheap", DEVA_PDES_HEAP_ARITY) &
+        deva::datarow::x("lazy_cancel", deva::os_env<bool>("deva_lazy_cancel", false)) &
+        deva::datarow::x("cd_throttle", deva::os_env<bool>("deva_cd_throttle", false)) &
+        deva::datarow::x("quantum", pdes::drain_quantum) &
+        deva::datarow::x("quantum_us", pdes::drain_quantum_us) &
+        deva::datarow::x("commit_slice", pdes::commit_slice) &
+        deva::datarow::x("commit_offload", pdes::commit_offload) &
+        deva::datarow::x("memory_budget", double(pdes::memory_budget)) &
         
         deva::datarow::y("execute_per_rank_per_sec", stats.executed_n/wall_secs/rank_n) &
         deva::datarow::y("commit_per_rank_per_sec", stats.committed_n/wall_secs/rank_n) &
-        deva::datarow::y("deterministic", stats.deterministic)
+        deva::datarow::y("cancel_avoided_frac", stats.cancel_avoided_fraction()) &
+        deva::datarow::y("deterministic", stats.deterministic) &
+        deva::datarow::y("live_bytes_hwm", double(stats.live_bytes_hwm)) &
+        deva::datarow::y("over_budget_n", double(stats.over_budget_n))
       );
     }
   };
 
-  deva::run(doit);
+  // sweep_quantum=1 reruns with each power-of-two drain quantum up to 64, or
+  // `deva_drain_quantum` if larger
+  if(deva::os_env<bool>("sweep_quantum", false)) {
+    int quantum_max = std::max(64, pdes::drain_quantum);
+    for(int q=1; q <= quantum_max; q *= 2) {
+      pdes::drain_quantum = q;
+      deva::run(doit);
+    }
+  }
+  else
+    deva::run(doit);
+  
   return 0;
 }
@@ -9,6 +9,8 @@
 #include <cstdint>
 #include <memory>
 
+#include <sys/resource.h>
+
 using namespace std;
 
 using deva::rank_n;
@@ -62,6 +64,121 @@ void bounce(rng_state rng) {
   });
 }
 
+// ping phase: rank 0 pings the others one at a time, `ping_gap_us` apart,
+// while they idle in `deva::progress(/*spinning=*/true)`. Measures how long a
+// message takes to be noticed by an idle rank against how much cpu idling costs.
+thread_local bool pinging;
+thread_local bool ponged;
+double ping_lat_sum; // only rank 0
+
+int64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+double thread_cpu_secs() {
+  rusage ru;
+  getrusage(RUSAGE_THREAD, &ru);
+  return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + 1e-6*(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec);
+}
+
+void ping_phase() {
+  int pings = deva::os_env<int>("pings", 1000);
+  int ping_gap_us = deva::os_env<int>("ping_gap_us", 100);
+  
+  pinging = true;
+  ping_lat_sum = 0;
+  deva::barrier();
+  
+  deva::bench::timer wall;
+  double cpu0 = thread_cpu_secs();
+  
+  if(deva::rank_me() == 0) {
+    for(int i=0; i < pings; i++) {
+      deva::bench::timer gap;
+      while(gap.elapsed() < 1e-6*ping_gap_us)
+        deva::progress(/*spinning=*/true);
+
+      ponged = false;
+      int64_t t_sent = now_ns();
+      deva::send(1 + i%(rank_n-1), [=]() {
+        int64_t t_got = now_ns();
+        deva::send(0, [=]() {
+          ping_lat_sum += 1e-3*(t_got - t_sent);
+          ponged = true;
+        });
+      });
+      
+      while(!ponged)
+        deva::progress(/*spinning=*/true);
+    }
+
+    for(int r=1; r < rank_n; r++)
+      deva::send(r, []() { pinging = false; });
+    pinging = false;
+  }
+  
+  while(pinging)
+    deva::progress(/*spinning=*/true);
+
+  double cpu_frac = (thread_cpu_secs() - cpu0)/wall.elapsed();
+  cpu_frac = deva::reduce_sum(cpu_frac)/rank_n;
+  
+  if(deva::rank_me() == 0) {
+    deva::bench::report rep(__FILE__);
+    rep.emit(
+      deva::datarow::x("ping_gap_us", ping_gap_us) &
+      deva::datarow::y("wake_latency_us", ping_lat_sum/pings) &
+      deva::datarow::y("idle_cpu_per_rank", cpu_frac)
+    );
+  }
+}
+
+// burst phase: every rank repeatedly sends `burst_n` messages to each other
+// rank, one by one or as a batch per destination.
+thread_local int64_t burst_recv_n;
+
+void burst_phase(bool batched) {
+  int burst_n = deva::os_env<int>("burst_n", 64);
+  int bursts = deva::os_env<int>("bursts", 2000);
+  int64_t expect_n = int64_t(bursts)*burst_n*(rank_n-1);
+  
+  burst_recv_n = 0;
+  deva::barrier();
+  deva::bench::timer wall;
+
+  for(int b=0; b < bursts; b++) {
+    for(int r=1; r < rank_n; r++) {
+      int dst = (rank_me() + r) % rank_n;
+      if(batched) {
+        auto batch = deva::send_local_batch(dst);
+        for(int i=0; i < burst_n; i++)
+          batch.send([]() { burst_recv_n += 1; });
+      }
+      else {
+        for(int i=0; i < burst_n; i++)
+          deva::send_local(dst, []() { burst_recv_n += 1; });
+      }
+    }
+    deva::progress();
+  }
+
+  while(burst_recv_n != expect_n)
+    deva::progress();
+  
+  double secs = deva::reduce_max(wall.elapsed());
+
+  if(deva::rank_me() == 0) {
+    deva::bench::report rep(__FILE__);
+    rep.emit(
+      deva::datarow::x("burst_n", burst_n) &
+      deva::datarow::x("batched", batched) &
+      deva::datarow::y("send_per_rank_per_sec", expect_n/secs)
+    );
+  }
+}
+
 int main() {
   auto doit = [&]() {
     int msg_per_rank = deva::os_env<int>("msg_per_rank", 100);
@@ -136,6 +253,14 @@ int main() {
         deva::datarow::y("send_per_rank_per_sec", tot_send_n/wall_secs/rank_n)
       );
     }
+
+    if(rank_n > 1) {
+      ping_phase();
+      if(deva::process_n == 1) {
+        burst_phase(false);
+        burst_phase(true);
+      }
+    }
   };
 
   deva::run(doit);
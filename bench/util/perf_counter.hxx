@@ -0,0 +1,76 @@
+#ifndef _1027f1ee61344638ab7e1f0ff404a18e
+#define _1027f1ee61344638ab7e1f0ff404a18e
+
+#include <cstdint>
+#include <cstring>
+
+#if __linux__
+  #include <linux/perf_event.h>
+  #include <sys/ioctl.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+#endif
+
+namespace deva {
+namespace bench {
+  // Counts a hardware event for the calling thread in user mode. Where perf
+  // events are unavailable (not linux, or disallowed by
+  // `perf_event_paranoid`) every count reads as -1.
+  class perf_counter {
+    int fd = -1;
+
+  public:
+    enum kind { cache_misses, l1d_read_misses };
+
+    perf_counter(kind k) {
+    #if __linux__
+      perf_event_attr a;
+      std::memset(&a, 0, sizeof(a));
+      a.size = sizeof(a);
+      if(k == cache_misses) {
+        a.type = PERF_TYPE_HARDWARE;
+        a.config = PERF_COUNT_HW_CACHE_MISSES;
+      }
+      else {
+        a.type = PERF_TYPE_HW_CACHE;
+        a.config = PERF_COUNT_HW_CACHE_L1D |
+                   PERF_COUNT_HW_CACHE_OP_READ<<8 |
+                   PERF_COUNT_HW_CACHE_RESULT_MISS<<16;
+      }
+      a.disabled = 1;
+      a.exclude_kernel = 1;
+      a.exclude_hv = 1;
+      fd = int(syscall(__NR_perf_event_open, &a, 0, -1, -1, 0));
+    #endif
+    }
+    perf_counter(perf_counter const&) = delete;
+    ~perf_counter() {
+    #if __linux__
+      if(fd >= 0)
+        close(fd);
+    #endif
+    }
+
+    void start() {
+    #if __linux__
+      if(fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+      }
+    #endif
+    }
+
+    std::int64_t stop() {
+    #if __linux__
+      std::int64_t n;
+      if(fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if(read(fd, &n, sizeof(n)) == sizeof(n))
+          return n;
+      }
+    #endif
+      return -1;
+    }
+  };
+}}
+#endif
@@ -136,11 +136,39 @@ def code_context(PATH):
       'DEVA_THREADS_SIGNAL_REAP_'+tsigreap.upper(): 1
     })
   
+  elif PATH == brutal.here('src/devastator/threads/idle.hxx'):
+    tidle = brutal.env('tidle', universe=('yield','spin','block'))
+    
+    cxt |= CodeContext(pp_defines={
+      'DEVA_THREADS_IDLE_'+tidle.upper(): 1
+    })
+  
+  elif PATH == brutal.here('src/devastator/threads/inline_ring.hxx'):
+    cxt |= CodeContext(pp_defines={
+      'DEVA_THREADS_INLINE_SIZE': brutal.env('tinline', universe=(64,0,128))
+    })
+  
   elif PATH == brutal.here('src/devastator/threads/message_mpsc.hxx'):
     cxt |= CodeContext(pp_defines={
       'DEVA_THREADS_MPSC_RAIL_N': brutal.env('trails', 1)
     })
   
+  elif PATH == brutal.here('src/devastator/pdes.hxx'):
+    pfuture = brutal.env('pfuture', universe=('heap','calendar','soa'))
+    pevpool = brutal.env('pevpool', universe=(1,0))
+    pheap = brutal.env('pheap', universe=(2,4,8))
+    cxt |= CodeContext(pp_defines={
+      'DEVA_PDES_FUTURE_'+pfuture.upper(): 1,
+      'DEVA_PDES_EVENT_POOL': pevpool,
+      'DEVA_PDES_HEAP_ARITY': pheap
+    })
+  
+  elif PATH == brutal.here('src/devastator/gvt.hxx'):
+    pgvt = brutal.env('pgvt', universe=('epoch','mattern'))
+    cxt |= CodeContext(pp_defines={
+      'DEVA_GVT_'+pgvt.upper(): 1
+    })
+  
   elif PATH == brutal.here('src/devastator/world.hxx'):
     world = get_world()
     cxt |= CodeContext(pp_defines={'DEVA_WORLD':1})
@@ -70,10 +70,11 @@ public:
     return result;
   }
 
-  // return Actor from local storage
+  // return Actor from local storage, any rank of the process may host it
+  // (see `pdes::migrate` and `pdes::cd_steal`)
   Actor & get_actor (int actor_id)
   {
-    DEVA_ASSERT(actor_id_to_rank(actor_id) == deva::rank_me());
+    DEVA_ASSERT(deva::rank_is_local(actor_id_to_rank(actor_id)));
     return actors[actor_id];
   }
 
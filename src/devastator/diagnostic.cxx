@@ -112,6 +112,15 @@ deva::datarow deva::describe() {
     DEVA_THREADS_ALLOC_EPOCH ? "epoch" :
     "");
 
+  #if DEVA_THREADS_SPSC || DEVA_THREADS_MPSC
+    ans &= datarow::x("tinline", DEVA_THREADS_INLINE_SIZE);
+  #endif
+
+  ans &= datarow::x("tidle",
+    DEVA_THREADS_IDLE_SPIN ? "spin" :
+    DEVA_THREADS_IDLE_BLOCK ? "block" :
+    "yield");
+
   #if DEVA_THREADS_SPSC
     ans &= datarow::x("tsigbits", DEVA_THREADS_SPSC_BITS);
     ans &= datarow::x("tsigreap",
@@ -0,0 +1,160 @@
+#ifndef _2f6b0e93c8d14a7e9a5d1c47b3e80f26
+#define _2f6b0e93c8d14a7e9a5d1c47b3e80f26
+
+#include <devastator/diagnostic.hxx>
+#include <devastator/utility.hxx>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace deva {
+  /* event_pool<T>: Per-thread slab allocator dedicated to objects of type `T`,
+   * meant to back a class's `operator new/delete` so hot allocations never
+   * reach the general purpose heap. Slabs are aligned to their own size so a
+   * block finds the slab header (and thus its owning pool) by masking its
+   * address. Blocks freed by a thread other than their owner are pushed onto
+   * the owner's lock-free return stack, which the owner swallows whole the
+   * next time its local free list runs dry.
+   *
+   * The slabs and return stack live in a heap `state` which outlives its
+   * thread while any block is still held elsewhere (by a committer thread or
+   * a far peer, say), the last such block returned frees it.
+   */
+  template<typename T>
+  class event_pool {
+    union block {
+      block *next;
+      alignas(T) unsigned char bytes[sizeof(T)];
+    };
+
+    struct state;
+    
+    struct slab_head {
+      state *owner;
+      slab_head *next;
+    };
+
+    struct state {
+      std::atomic<block*> returned{nullptr};
+      slab_head *slabs = nullptr;
+      // Blocks freed by other threads. Once the owner exits it subtracts the
+      // blocks it handed out and didn't free itself, so reaching zero from
+      // below means the last one is back.
+      std::atomic<std::intptr_t> freed_far{0};
+
+      void release();
+    };
+
+    static constexpr std::size_t head_size =
+      (sizeof(slab_head) + alignof(block)-1) & -alignof(block);
+
+    static constexpr std::size_t slab_size_min = std::size_t(1)<<16;
+    static constexpr std::size_t slab_size =
+      head_size + 16*sizeof(block) <= slab_size_min
+        ? slab_size_min
+        : std::size_t(1)<<log_up(int(head_size + 16*sizeof(block)), 2);
+
+    static constexpr int slab_block_n = int((slab_size - head_size)/sizeof(block));
+
+    block *free_ = nullptr;
+    state *st_ = nullptr;
+    std::intptr_t held_ = 0; // handed out less freed by us
+
+    static thread_local event_pool the_pool;
+
+  public:
+    constexpr event_pool() = default;
+    event_pool(event_pool const&) = delete;
+    ~event_pool();
+
+    static void* allocate();
+    static void deallocate(void *o);
+
+  private:
+    block* grow();
+  };
+
+  template<typename T>
+  thread_local event_pool<T> event_pool<T>::the_pool;
+
+  template<typename T>
+  inline void* event_pool<T>::allocate() {
+    event_pool *me = &the_pool;
+    block *b = me->free_;
+
+    if(b == nullptr) {
+      if(me->st_ != nullptr)
+        b = me->st_->returned.exchange(nullptr, std::memory_order_acquire);
+      if(b == nullptr)
+        b = me->grow();
+    }
+
+    me->free_ = b->next;
+    me->held_ += 1;
+    return b;
+  }
+
+  template<typename T>
+  inline void event_pool<T>::deallocate(void *o) {
+    block *b = static_cast<block*>(o);
+    slab_head *s = reinterpret_cast<slab_head*>(
+      reinterpret_cast<std::uintptr_t>(o) & -std::uintptr_t(slab_size)
+    );
+    state *owner = s->owner;
+    event_pool *me = &the_pool;
+
+    if(owner == me->st_) {
+      b->next = me->free_;
+      me->free_ = b;
+      me->held_ -= 1;
+    }
+    else {
+      // deferred return to another thread's pool
+      block *top = owner->returned.load(std::memory_order_relaxed);
+      do b->next = top;
+      while(!owner->returned.compare_exchange_weak(top, b, std::memory_order_release, std::memory_order_relaxed));
+
+      if(owner->freed_far.fetch_add(1, std::memory_order_acq_rel) == -1)
+        owner->release(); // its thread is gone and this was the last block out
+    }
+  }
+
+  template<typename T>
+  event_pool<T>::~event_pool() {
+    if(st_ != nullptr && held_ == st_->freed_far.fetch_sub(held_, std::memory_order_acq_rel))
+      st_->release();
+  }
+
+  template<typename T>
+  void event_pool<T>::state::release() {
+    slab_head *s = slabs;
+    while(s != nullptr) {
+      slab_head *s1 = s->next;
+      std::free(s);
+      s = s1;
+    }
+    delete this;
+  }
+
+  template<typename T>
+  typename event_pool<T>::block* event_pool<T>::grow() {
+    if(st_ == nullptr)
+      st_ = new state;
+    
+    void *m;
+    int ok = posix_memalign(&m, slab_size, slab_size);
+    DEVA_ASSERT_ALWAYS(ok == 0, "event_pool: posix_memalign of "<<slab_size<<" bytes failed.");
+
+    slab_head *s = ::new(m) slab_head{st_, st_->slabs};
+    st_->slabs = s;
+
+    block *bs = reinterpret_cast<block*>(reinterpret_cast<char*>(m) + head_size);
+    for(int i=0; i < slab_block_n-1; i++)
+      bs[i].next = &bs[i+1];
+    bs[slab_block_n-1].next = nullptr;
+    return bs;
+  }
+}
+#endif
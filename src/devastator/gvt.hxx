@@ -1,14 +1,35 @@
 #ifndef _a0009246_4028_4372_88b9_4bbf7c6096f9
 #define _a0009246_4028_4372_88b9_4bbf7c6096f9
 
+#ifndef DEVA_GVT_EPOCH
+  #define DEVA_GVT_EPOCH 0
+#endif
+
+#ifndef DEVA_GVT_MATTERN
+  #define DEVA_GVT_MATTERN 0
+#endif
+
 #include <devastator/diagnostic.hxx>
 #include <devastator/world.hxx>
 
 #include <array>
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
 
 namespace deva {
+  //////////////////////////////////////////////////////////////////////////////
+  // Public API
+  //
+  // Two engines implement it, chosen at build time (brutal option `pgvt`):
+  //  epoch: Each collective closes an epoch of message counting and ends
+  //    quiesced only if every message of the epoch before it was received by
+  //    then, otherwise it must be retried.
+  //  mattern: Mattern's two cut colored message algorithm. The first cut
+  //    gathers how many messages each rank is owed, every rank then waits to
+  //    receive its own before joining the second cut, so every collective ends
+  //    quiesced at the price of a second reduction.
+  
   namespace gvt {
     struct reducibles {
       std::uint64_t sum1, sum2;
@@ -19,6 +40,18 @@ namespace deva {
       }
     };
     
+    // Fan-in of the reduction tree over processes, ranks within a process
+    // always combine through shared memory. Default from env var
+    // `deva_gvt_radix` (4), at least 2.
+    extern int radix;
+    
+    // Most collectives kept in flight at once, each one closes an epoch of
+    // message counting as it begins so the next can start before earlier ones
+    // have come back down. Default from env var `deva_gvt_pipeline` (1), read
+    // by `init()`. The mattern engine always keeps at most one.
+    constexpr int pipeline_max = 8;
+    extern int pipeline;
+    
     void init(std::uint64_t gvt, reducibles rxs0);
     
     template<bool3 local, typename Fn, typename ...Arg>
@@ -29,112 +62,51 @@ namespace deva {
 
     template<typename ProcFn1>
     void bcast_procs(std::uint64_t t_lb, std::int32_t credit_n, ProcFn1 &&proc_fn);
-    
+
+    // From within the handler of a message of `send` or `bcast_procs`, passes
+    // part of it (timestamped `t`) on to `rank` under the epoch tag it came
+    // with. That part then counts as received where it lands rather than here,
+    // so its epoch only settles once it has. The mattern engine, whose counts
+    // are owed per destination, just sends it afresh.
+    template<bool3 local, typename Fn, typename ...Arg>
+    void forward(int rank, cbool3<local>, std::uint64_t t, Fn &&fn, Arg &&...arg);
+
+    // Picks up the result of the oldest collective in flight if it has ended.
     void advance();
 
+    // Whether another collective may begin: fewer than `pipeline` are in flight
+    // and, when pipelining, enough time has passed since the last one began to
+    // space them evenly over a round trip. A rank must be done acting on every
+    // result it has picked up before beginning the next collective.
+    bool coll_can_begin();
     void coll_begin(std::uint64_t lvt, reducibles rxs);
+    int coll_in_flight();
+    
+    // Whether the last `advance()` picked up a result, and its contents.
     bool coll_ended();
     reducibles coll_reducibles();
-
     bool coll_was_epoch();
-    std::uint64_t epoch_gvt();
-  }
-
-  namespace gvt {
-    enum class coll_status_e  {
-      reducing,
-      quiesced,
-      non_quiesced,
-    };
-
-    extern __thread coll_status_e coll_status_[2];
-    extern __thread reducibles coll_rxs_[2];
-    extern __thread std::uint64_t epoch_gvt_[2];
     
-    extern __thread unsigned epoch_;
-    extern __thread std::uint64_t epoch_lvt_[2];
-    extern __thread std::uint64_t epoch_lsend_[2];
-    extern __thread std::uint64_t epoch_lrecv_[3];
-  }
-
-  inline void gvt::advance() {
-    coll_status_[0] = coll_status_[1];
-    coll_rxs_[0] = coll_rxs_[1];
-    epoch_gvt_[0] = epoch_gvt_[1];
-  }
-  
-  inline bool gvt::coll_ended() {
-    return coll_status_[0] != coll_status_e::reducing;
-  }
-  
-  inline gvt::reducibles gvt::coll_reducibles() {
-    return coll_rxs_[0];
-  }
-
-  inline bool gvt::coll_was_epoch() {
-    return coll_status_[0] == coll_status_e::quiesced;
-  }
-  
-  inline std::uint64_t gvt::epoch_gvt() {
-    return epoch_gvt_[0];
-  }
-
-  template<typename Fn, typename ...Arg>
-  void gvt::send(int rank, std::uint64_t t, Fn &&fn, Arg &&...arg) {
-    gvt::send(rank, cmaybe3, t, static_cast<Fn&&>(fn), static_cast<Arg&&>(arg)...);
-  }
-  
-  template<bool3 local, typename Fn1, typename ...Arg>
-  void gvt::send(int rank, cbool3<local> local1, std::uint64_t t, Fn1 &&fn, Arg &&...arg) {
-    using Fn = typename std::decay<Fn1>::type;
-    DEVA_ASSERT(epoch_gvt_[0] <= t);
-    
-    unsigned e = epoch_ + 1;
-    epoch_lsend_[1] += 1;
-    epoch_lvt_[1] = std::min(epoch_lvt_[1], t);
+    std::uint64_t epoch_gvt();
+    // The `epoch_gvt()` as of `pipeline` results ago, which every rank has
+    // picked up and acted upon.
+    std::uint64_t epoch_gvt_agreed();
+    // How many more collectives must begin, after the result just picked up,
+    // before `epoch_gvt_agreed()` catches up to its `epoch_gvt()`.
+    int coll_until_agreed();
     
-    deva::send(rank, local1,
-      [=](Fn &&fn, typename std::decay<Arg>::type &&...arg) {
-        int i = e >= epoch_ ? int(e - epoch_) : -int(epoch_ - e);
-        DEVA_ASSERT(0 <= i && i < 3);
-        DEVA_ASSERT(epoch_gvt_[0] <= t);
-        
-        epoch_lrecv_[i] += 1;
-        
-        static_cast<Fn&&>(fn)(static_cast<typename std::decay<Arg>::type&&>(arg)...);
-      },
-      static_cast<Fn1&&>(fn), static_cast<Arg&&>(arg)...
-    );
+    // Messages are tagged with the epoch current at their send, after an
+    // epoch result every message tagged at or below `epoch_settled()` has
+    // been received.
+    std::uint64_t epoch_sending();
+    std::uint64_t epoch_settled();
   }
+}
 
-  template<typename ProcFn1>
-  void gvt::bcast_procs(std::uint64_t t_lb, std::int32_t credits, ProcFn1 &&proc_fn) {
-    using ProcFn = typename std::decay<ProcFn1>::type;
-    DEVA_ASSERT(epoch_gvt_[0] <= t_lb);
-    
-    unsigned e = epoch_ + 1;
-    epoch_lsend_[1] += credits;
-    epoch_lvt_[1] = std::min(epoch_lvt_[1], t_lb);
+#if DEVA_GVT_MATTERN
+  #include <devastator/gvt/gvt_mattern.hxx>
+#else
+  #include <devastator/gvt/gvt_epoch.hxx>
+#endif
 
-    deva::bcast_procs(
-      deva::bind(
-        [=](ProcFn &&proc_fn1) {
-          proc_fn1(/*run_at_rank*/[&](int rank, auto fn) {
-            deva::send_local(rank,
-              [=, fn1(std::move(fn))]() {
-                int i = e >= epoch_ ? int(e - epoch_) : -int(epoch_ - e);
-                DEVA_ASSERT(0 <= i && i < 3);
-                DEVA_ASSERT(epoch_gvt_[0] <= t_lb);
-                
-                std::int32_t credits = fn1();
-                epoch_lrecv_[i] += credits;
-              }
-            );
-          });
-        },
-        static_cast<ProcFn1&&>(proc_fn)
-      )
-    );
-  }
-} // namespace deva
 #endif
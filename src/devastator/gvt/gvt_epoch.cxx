@@ -0,0 +1,202 @@
+#include <devastator/gvt/gvt_epoch.hxx>
+
+#include <atomic>
+#include <chrono>
+
+using namespace std;
+
+namespace gvt = deva::gvt;
+
+namespace deva {
+  namespace gvt {
+    __thread uint64_t round_begun_, round_seen_;
+    __thread bool coll_ended_;
+    __thread coll_result coll_last_;
+    __thread uint64_t epoch_gvt_;
+    __thread uint64_t epoch_gvt_hist_[pipeline_max+1];
+    __thread int pipeline_;
+
+    __thread uint64_t send_open_, send_open_lvt_;
+    __thread uint64_t recv_ring_[recv_ring_n];
+    __thread uint64_t recv_cum_;
+    __thread uint64_t recv_tag_;
+
+    std::atomic<uint64_t> coll_published_[pipeline_max];
+  }
+}
+
+namespace {
+  /* Message counting: round r closes epoch r as it begins, so messages sent
+   * after are tagged r+1. Each rank contributes the number of messages it sent
+   * tagged before r (all sent before it began round r-1) and received so far
+   * with such tags, along with the least of its lvt and the timestamps it sent
+   * tagged r. Matching totals mean every message tagged before r was received
+   * before its receiver began round r, making the least contribution a valid
+   * gvt. Each round stands alone so up to `pipeline` may be in flight.
+   *
+   * The reduction is two level. Ranks of a process combine their
+   * contributions into `proc_acc` with atomics, the last to arrive (whichever
+   * rank that is) carries the process total up a `gvt::radix`-ary tree over
+   * processes to the parent's lowest rank. Child process totals are folded into
+   * the same accumulator. On the way down the rank completing a process forwards
+   * to its child processes and publishes into `proc_result`, which every rank
+   * of the process picks up in `gvt::advance()`. Rounds use the slots of their
+   * index modulo `pipeline_max`.
+   */
+  struct alignas(64) proc_acc_t {
+    std::atomic<int> arrived{0};
+    std::atomic<uint64_t> gvt{~uint64_t(0)};
+    std::atomic<uint64_t> gsend{0}, grecv{0};
+    std::atomic<uint64_t> sum1{0}, sum2{0};
+  } proc_acc[gvt::pipeline_max];
+
+  struct alignas(64) proc_result_t {
+    gvt::coll_result r;
+  } proc_result[gvt::pipeline_max];
+
+  __thread uint64_t send_cum_; // sent with tags before the open one
+
+  // spacing of pipelined rounds
+  __thread chrono::steady_clock::time_point round_t0_[gvt::pipeline_max];
+  __thread chrono::steady_clock::duration round_dt_avg_;
+
+  int proc_child_lb(int proc) {
+    return std::min<long>(deva::process_n, long(proc)*gvt::radix + 1);
+  }
+  int proc_child_ub(int proc) {
+    return std::min<long>(deva::process_n, long(proc)*gvt::radix + gvt::radix + 1);
+  }
+
+  void rdxn_up(uint64_t round, uint64_t lvt, uint64_t lsend, uint64_t lrecv, gvt::reducibles rxs);
+  void rdxn_down(uint64_t round, gvt::coll_result res);
+}
+
+void deva::gvt::init(uint64_t gvt0, gvt::reducibles rxs0) {
+  pipeline_ = std::max(1, std::min(pipeline_max, pipeline));
+
+  round_begun_ = 0;
+  round_seen_ = 0;
+  coll_ended_ = false;
+  coll_last_ = {/*quiesced=*/false, gvt0, rxs0};
+  epoch_gvt_ = gvt0;
+  for(uint64_t &g: epoch_gvt_hist_)
+    g = gvt0;
+
+  send_open_ = 0;
+  send_open_lvt_ = gvt0;
+  send_cum_ = 0;
+  for(uint64_t &n: recv_ring_)
+    n = 0;
+  recv_cum_ = 0;
+  round_dt_avg_ = {};
+
+  // every rank must be done reading result slots before they are reset
+  deva::barrier();
+  if(deva::rank_me_local() == 0) {
+    for(auto &p: coll_published_)
+      p.store(0, std::memory_order_relaxed);
+  }
+  deva::barrier();
+}
+
+bool deva::gvt::coll_can_begin() {
+  uint64_t n = round_begun_ - round_seen_;
+  if(n == 0)
+    return true;
+  if(n >= uint64_t(pipeline_))
+    return false;
+
+  auto since = chrono::steady_clock::now() - round_t0_[round_begun_ % pipeline_max];
+  return since*pipeline_ >= round_dt_avg_;
+}
+
+void deva::gvt::coll_begin(std::uint64_t lvt, gvt::reducibles rxs) {
+  DEVA_ASSERT(coll_in_flight() < pipeline_);
+
+  uint64_t r = ++round_begun_;
+
+  uint64_t lsend = send_cum_;
+  send_cum_ += send_open_;
+  send_open_ = 0;
+
+  lvt = std::min(lvt, send_open_lvt_);
+  send_open_lvt_ = ~uint64_t(0);
+
+  recv_cum_ += recv_ring_[(r-1) % recv_ring_n];
+  recv_ring_[(r-1) % recv_ring_n] = 0;
+
+  if(pipeline_ != 1)
+    round_t0_[r % pipeline_max] = chrono::steady_clock::now();
+
+  rdxn_up(r, lvt, lsend, recv_cum_, rxs);
+}
+
+void deva::gvt::coll_pick_up_() {
+  uint64_t r = ++round_seen_;
+
+  coll_ended_ = true;
+  coll_last_ = proc_result[r % pipeline_max].r;
+  if(coll_last_.quiesced) {
+    DEVA_ASSERT(epoch_gvt_ <= coll_last_.gvt);
+    epoch_gvt_ = coll_last_.gvt;
+  }
+  epoch_gvt_hist_[r % (pipeline_max+1)] = epoch_gvt_;
+
+  if(pipeline_ != 1) {
+    auto dt = chrono::steady_clock::now() - round_t0_[r % pipeline_max];
+    round_dt_avg_ += (dt - round_dt_avg_)/8;
+  }
+}
+
+namespace {
+  void rdxn_up(uint64_t round, uint64_t lvt, uint64_t lsend, uint64_t lrecv, deva::gvt::reducibles rxs) {
+    const int proc_me = deva::process_me();
+    const int incoming = deva::worker_n + proc_child_ub(proc_me) - proc_child_lb(proc_me);
+    proc_acc_t &acc = proc_acc[round % gvt::pipeline_max];
+
+    { // fold in with atomics
+      uint64_t gvt = acc.gvt.load(std::memory_order_relaxed);
+      while(lvt < gvt && !acc.gvt.compare_exchange_weak(gvt, lvt, std::memory_order_relaxed));
+
+      acc.gsend.fetch_add(lsend, std::memory_order_relaxed);
+      acc.grecv.fetch_add(lrecv, std::memory_order_relaxed);
+      acc.sum1.fetch_add(rxs.sum1, std::memory_order_relaxed);
+      acc.sum2.fetch_add(rxs.sum2, std::memory_order_relaxed);
+    }
+
+    if(incoming != 1 + acc.arrived.fetch_add(1, std::memory_order_acq_rel))
+      return;
+
+    // last to arrive: drain the accumulator back to identity and carry it on
+    acc.arrived.store(0, std::memory_order_relaxed);
+    lvt = acc.gvt.exchange(~uint64_t(0), std::memory_order_relaxed);
+    lsend = acc.gsend.exchange(0, std::memory_order_relaxed);
+    lrecv = acc.grecv.exchange(0, std::memory_order_relaxed);
+    rxs.sum1 = acc.sum1.exchange(0, std::memory_order_relaxed);
+    rxs.sum2 = acc.sum2.exchange(0, std::memory_order_relaxed);
+
+    if(proc_me == 0) {
+      //say()<<"root gvt="<<lvt<<" send="<<lsend<<" recv="<<lrecv;
+      rdxn_down(round, {/*quiesced=*/lsend == lrecv, lvt, rxs});
+    }
+    else {
+      int parent = deva::process_rank_lo((proc_me-1)/gvt::radix);
+      deva::send(parent, [=]() {
+        rdxn_up(round, lvt, lsend, lrecv, rxs);
+      });
+    }
+  }
+
+  void rdxn_down(uint64_t round, gvt::coll_result res) {
+    const int proc_me = deva::process_me();
+
+    for(int kid = proc_child_lb(proc_me); kid < proc_child_ub(proc_me); kid++) {
+      deva::send(deva::process_rank_lo(kid), [=]() {
+        rdxn_down(round, res);
+      });
+    }
+
+    proc_result[round % gvt::pipeline_max].r = res;
+    gvt::coll_published_[round % gvt::pipeline_max].store(round, std::memory_order_release);
+  }
+}
@@ -0,0 +1,162 @@
+// The forwarded API this header is implementing.
+#include <devastator/gvt.hxx>
+
+#ifndef _5c1e4a7d2b9f4e0c8a63d1f27b94e805
+#define _5c1e4a7d2b9f4e0c8a63d1f27b94e805
+
+namespace deva {
+  namespace gvt {
+    struct coll_result {
+      bool quiesced;
+      std::uint64_t gvt;
+      reducibles rxs;
+    };
+    
+    extern __thread std::uint64_t round_begun_, round_seen_;
+    extern __thread bool coll_ended_;
+    extern __thread coll_result coll_last_;
+    extern __thread std::uint64_t epoch_gvt_;
+    extern __thread std::uint64_t epoch_gvt_hist_[pipeline_max+1]; // by result round
+    extern __thread int pipeline_;
+
+    // per epoch tag message counts
+    constexpr int recv_ring_n = 2*pipeline_max;
+    extern __thread std::uint64_t send_open_, send_open_lvt_;
+    extern __thread std::uint64_t recv_ring_[recv_ring_n];
+    extern __thread std::uint64_t recv_cum_;
+    extern __thread std::uint64_t recv_tag_; // of the message being handled
+    
+    // round published into each result slot of this process (one based)
+    extern std::atomic<std::uint64_t> coll_published_[pipeline_max];
+    void coll_pick_up_();
+    
+    inline void count_recv_(std::uint64_t e, std::uint64_t n) {
+      // tags before the last one closed were already folded
+      if(e < round_begun_)
+        recv_cum_ += n;
+      else {
+        DEVA_ASSERT(e < round_begun_ + recv_ring_n);
+        recv_ring_[e % recv_ring_n] += n;
+      }
+    }
+  }
+
+  inline void gvt::advance() {
+    coll_ended_ = false;
+    if(round_seen_ != round_begun_ &&
+       round_seen_+1 == coll_published_[(round_seen_+1) % pipeline_max].load(std::memory_order_acquire))
+      coll_pick_up_();
+  }
+
+  inline int gvt::coll_in_flight() {
+    return int(round_begun_ - round_seen_);
+  }
+  
+  inline bool gvt::coll_ended() {
+    return coll_ended_;
+  }
+  
+  inline gvt::reducibles gvt::coll_reducibles() {
+    return coll_last_.rxs;
+  }
+
+  inline bool gvt::coll_was_epoch() {
+    return coll_last_.quiesced;
+  }
+  
+  inline std::uint64_t gvt::epoch_gvt() {
+    return epoch_gvt_;
+  }
+
+  inline std::uint64_t gvt::epoch_gvt_agreed() {
+    return epoch_gvt_hist_[(round_seen_ + pipeline_max+1 - pipeline_) % (pipeline_max+1)];
+  }
+
+  inline int gvt::coll_until_agreed() {
+    return pipeline_ - 1 - coll_in_flight();
+  }
+
+  inline std::uint64_t gvt::epoch_sending() {
+    return round_begun_ + 1;
+  }
+
+  inline std::uint64_t gvt::epoch_settled() {
+    return round_seen_ - 1;
+  }
+
+  template<typename Fn, typename ...Arg>
+  void gvt::send(int rank, std::uint64_t t, Fn &&fn, Arg &&...arg) {
+    gvt::send(rank, cmaybe3, t, static_cast<Fn&&>(fn), static_cast<Arg&&>(arg)...);
+  }
+  
+  template<bool3 local, typename Fn1, typename ...Arg>
+  void gvt::send(int rank, cbool3<local> local1, std::uint64_t t, Fn1 &&fn, Arg &&...arg) {
+    using Fn = typename std::decay<Fn1>::type;
+    DEVA_ASSERT(epoch_gvt_ <= t);
+    
+    std::uint64_t e = round_begun_ + 1;
+    send_open_ += 1;
+    send_open_lvt_ = std::min(send_open_lvt_, t);
+    
+    deva::send(rank, local1,
+      [=](Fn &&fn, typename std::decay<Arg>::type &&...arg) {
+        DEVA_ASSERT(epoch_gvt_ <= t);
+        count_recv_(e, 1);
+        recv_tag_ = e;
+        
+        static_cast<Fn&&>(fn)(static_cast<typename std::decay<Arg>::type&&>(arg)...);
+      },
+      static_cast<Fn1&&>(fn), static_cast<Arg&&>(arg)...
+    );
+  }
+
+  template<bool3 local, typename Fn1, typename ...Arg>
+  void gvt::forward(int rank, cbool3<local> local1, std::uint64_t t, Fn1 &&fn, Arg &&...arg) {
+    using Fn = typename std::decay<Fn1>::type;
+    DEVA_ASSERT(epoch_gvt_ <= t);
+    
+    std::uint64_t e = recv_tag_;
+    count_recv_(e, ~std::uint64_t(0)); // take back its share of our receipt
+    
+    deva::send(rank, local1,
+      [=](Fn &&fn, typename std::decay<Arg>::type &&...arg) {
+        DEVA_ASSERT(epoch_gvt_ <= t);
+        count_recv_(e, 1);
+        recv_tag_ = e;
+        
+        static_cast<Fn&&>(fn)(static_cast<typename std::decay<Arg>::type&&>(arg)...);
+      },
+      static_cast<Fn1&&>(fn), static_cast<Arg&&>(arg)...
+    );
+  }
+
+  template<typename ProcFn1>
+  void gvt::bcast_procs(std::uint64_t t_lb, std::int32_t credits, ProcFn1 &&proc_fn) {
+    using ProcFn = typename std::decay<ProcFn1>::type;
+    DEVA_ASSERT(epoch_gvt_ <= t_lb);
+    
+    std::uint64_t e = round_begun_ + 1;
+    send_open_ += credits;
+    send_open_lvt_ = std::min(send_open_lvt_, t_lb);
+
+    deva::bcast_procs(
+      deva::bind(
+        [=](ProcFn &&proc_fn1) {
+          proc_fn1(/*run_at_rank*/[&](int rank, auto fn) {
+            deva::send_local(rank,
+              [=, fn1(std::move(fn))]() {
+                DEVA_ASSERT(epoch_gvt_ <= t_lb);
+                recv_tag_ = e;
+                
+                std::int32_t credits = fn1();
+                count_recv_(e, credits);
+              }
+            );
+          });
+        },
+        static_cast<ProcFn1&&>(proc_fn)
+      )
+    );
+  }
+} // namespace deva
+#endif
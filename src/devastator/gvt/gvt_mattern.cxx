@@ -0,0 +1,280 @@
+#include <devastator/gvt/gvt_mattern.hxx>
+
+#include <atomic>
+#include <vector>
+
+using namespace std;
+
+namespace gvt = deva::gvt;
+
+namespace deva {
+  namespace gvt {
+    __thread uint64_t round_begun_, round_seen_;
+    __thread phase_t phase_;
+    __thread bool coll_ended_;
+    __thread coll_result coll_last_;
+    __thread uint64_t epoch_gvt_, epoch_gvt_prev_;
+
+    __thread uint32_t send_open_to_[deva::rank_n];
+    __thread uint64_t bcast_open_;
+    __thread uint64_t send_lvt_, recv_white_lvt_;
+    __thread uint64_t recv_ring_[tag_ring_n];
+
+    bcast_counts bcast_ring_[tag_ring_n];
+  }
+}
+
+namespace {
+  /* Round r has every rank turn white to red as it begins (first cut),
+   * messages sent before are tagged r and those after r+1. The first cut sums
+   * how many tag r messages went to each rank, plus how many tag r bcasts were
+   * sent, each of which arrives once at every process. Once a rank has
+   * received all those owed to it and its process has seen every bcast arrive
+   * and its forwards to local ranks land, it joins the second cut with the
+   * least of: its lvt at the first cut, the white messages it has received
+   * since, and the red ones it has sent. No white message is in flight past
+   * the second cut, so its minimum is always a valid gvt.
+   *
+   * Both cuts reduce like the epoch engine: ranks of a process combine with
+   * atomics into a process accumulator, the last to arrive carries it up a
+   * `gvt::radix`-ary tree over processes and results are published back down
+   * into process shared slots. Only one round is in flight at a time so each
+   * cut has one slot.
+   */
+  constexpr int owed_n = deva::rank_n + 1; // last one counts bcasts
+
+  struct alignas(64) cut1_acc_t {
+    std::atomic<int> arrived{0};
+    std::atomic<uint64_t> owed[owed_n];
+  } cut1_acc;
+
+  struct alignas(64) cut2_acc_t {
+    std::atomic<int> arrived{0};
+    std::atomic<uint64_t> gvt{~uint64_t(0)};
+    std::atomic<uint64_t> sum1{0}, sum2{0};
+  } cut2_acc;
+
+  // round whose result is in each cut's slot
+  std::atomic<uint64_t> cut1_published, cut2_published;
+  uint64_t cut1_owed[deva::worker_n], cut1_owed_bcasts;
+  gvt::coll_result cut2_result;
+
+  __thread uint64_t lvt_cut1_;
+  __thread gvt::reducibles rxs_cut1_;
+  __thread uint64_t owed_me_, owed_bcasts_;
+
+  int proc_child_lb(int proc) {
+    return std::min<long>(deva::process_n, long(proc)*gvt::radix + 1);
+  }
+  int proc_child_ub(int proc) {
+    return std::min<long>(deva::process_n, long(proc)*gvt::radix + gvt::radix + 1);
+  }
+
+  void cut1_arrive(uint64_t round);
+  void cut1_down(uint64_t round, std::vector<uint64_t> const &owed);
+  void cut2_arrive(uint64_t round, uint64_t lvt, gvt::reducibles rxs);
+  void cut2_down(uint64_t round, gvt::coll_result res);
+}
+
+void deva::gvt::init(uint64_t gvt0, gvt::reducibles rxs0) {
+  round_begun_ = 0;
+  round_seen_ = 0;
+  phase_ = phase_t::idle;
+  coll_ended_ = false;
+  coll_last_ = {/*quiesced=*/true, gvt0, rxs0};
+  epoch_gvt_ = gvt0;
+  epoch_gvt_prev_ = gvt0;
+
+  for(uint32_t &n: send_open_to_)
+    n = 0;
+  bcast_open_ = 0;
+  send_lvt_ = ~uint64_t(0);
+  recv_white_lvt_ = ~uint64_t(0);
+  for(uint64_t &n: recv_ring_)
+    n = 0;
+
+  // every rank must be done reading process slots before they are reset
+  deva::barrier();
+  if(deva::rank_me_local() == 0) {
+    cut1_published.store(0, std::memory_order_relaxed);
+    cut2_published.store(0, std::memory_order_relaxed);
+    for(bcast_counts &bc: bcast_ring_) {
+      bc.arrived.store(0, std::memory_order_relaxed);
+      bc.fwd_sent.store(0, std::memory_order_relaxed);
+      bc.fwd_recv.store(0, std::memory_order_relaxed);
+    }
+  }
+  deva::barrier();
+}
+
+void deva::gvt::coll_begin(std::uint64_t lvt, gvt::reducibles rxs) {
+  DEVA_ASSERT(phase_ == phase_t::idle);
+
+  uint64_t r = ++round_begun_;
+  phase_ = phase_t::cut1;
+  lvt_cut1_ = lvt;
+  rxs_cut1_ = rxs;
+  send_lvt_ = ~uint64_t(0);
+  recv_white_lvt_ = ~uint64_t(0);
+
+  for(int rank=0; rank < deva::rank_n; rank++) {
+    if(send_open_to_[rank] != 0) {
+      cut1_acc.owed[rank].fetch_add(send_open_to_[rank], std::memory_order_relaxed);
+      send_open_to_[rank] = 0;
+    }
+  }
+  if(bcast_open_ != 0) {
+    cut1_acc.owed[deva::rank_n].fetch_add(bcast_open_, std::memory_order_relaxed);
+    bcast_open_ = 0;
+  }
+
+  cut1_arrive(r);
+}
+
+void deva::gvt::advance_slow_() {
+  const uint64_t r = round_begun_;
+
+  switch(phase_) {
+  case phase_t::idle:
+    return;
+
+  case phase_t::cut1:
+    if(cut1_published.load(std::memory_order_acquire) != r)
+      return;
+    owed_me_ = cut1_owed[deva::rank_me_local()];
+    owed_bcasts_ = cut1_owed_bcasts;
+    phase_ = phase_t::owed;
+    // fallthrough
+
+  case phase_t::owed: {
+    DEVA_ASSERT(recv_ring_[r % tag_ring_n] <= owed_me_);
+    if(recv_ring_[r % tag_ring_n] != owed_me_)
+      return;
+
+    // once all bcasts arrived every forward has been counted as sent
+    bcast_counts &bc = bcast_ring_[r % tag_ring_n];
+    if(bc.arrived.load(std::memory_order_acquire) != owed_bcasts_)
+      return;
+    if(bc.fwd_recv.load(std::memory_order_acquire) != bc.fwd_sent.load(std::memory_order_relaxed))
+      return;
+
+    phase_ = phase_t::cut2;
+    cut2_arrive(r, std::min(lvt_cut1_, std::min(send_lvt_, recv_white_lvt_)), rxs_cut1_);
+  } // fallthrough
+
+  case phase_t::cut2:
+    if(cut2_published.load(std::memory_order_acquire) != r)
+      return;
+
+    round_seen_ = r;
+    phase_ = phase_t::idle;
+    recv_ring_[r % tag_ring_n] = 0;
+
+    coll_ended_ = true;
+    coll_last_ = cut2_result;
+    DEVA_ASSERT(epoch_gvt_ <= coll_last_.gvt);
+    epoch_gvt_prev_ = epoch_gvt_;
+    epoch_gvt_ = coll_last_.gvt;
+    return;
+  }
+}
+
+namespace {
+  void cut1_arrive(uint64_t round) {
+    const int proc_me = deva::process_me();
+    const int incoming = deva::worker_n + proc_child_ub(proc_me) - proc_child_lb(proc_me);
+
+    if(incoming != 1 + cut1_acc.arrived.fetch_add(1, std::memory_order_acq_rel))
+      return;
+
+    // last to arrive: drain the accumulator back to zero and carry it on
+    cut1_acc.arrived.store(0, std::memory_order_relaxed);
+    std::vector<uint64_t> owed(owed_n);
+    for(int i=0; i < owed_n; i++)
+      owed[i] = cut1_acc.owed[i].exchange(0, std::memory_order_relaxed);
+
+    if(proc_me == 0)
+      cut1_down(round, owed);
+    else {
+      int parent = deva::process_rank_lo((proc_me-1)/gvt::radix);
+      deva::send(parent,
+        [=](std::vector<uint64_t> &&owed) {
+          for(int i=0; i < owed_n; i++) {
+            if(owed[i] != 0)
+              cut1_acc.owed[i].fetch_add(owed[i], std::memory_order_relaxed);
+          }
+          cut1_arrive(round);
+        },
+        std::move(owed)
+      );
+    }
+  }
+
+  void cut1_down(uint64_t round, std::vector<uint64_t> const &owed) {
+    const int proc_me = deva::process_me();
+
+    for(int kid = proc_child_lb(proc_me); kid < proc_child_ub(proc_me); kid++) {
+      deva::send(deva::process_rank_lo(kid),
+        [=](std::vector<uint64_t> &&owed) {
+          cut1_down(round, owed);
+        },
+        owed
+      );
+    }
+
+    const int rank_lo = deva::process_rank_lo();
+    for(int i=0; i < deva::worker_n; i++)
+      cut1_owed[i] = owed[rank_lo + i];
+    cut1_owed_bcasts = owed[deva::rank_n];
+    cut1_published.store(round, std::memory_order_release);
+  }
+
+  void cut2_arrive(uint64_t round, uint64_t lvt, gvt::reducibles rxs) {
+    const int proc_me = deva::process_me();
+    const int incoming = deva::worker_n + proc_child_ub(proc_me) - proc_child_lb(proc_me);
+
+    { // fold in with atomics
+      uint64_t gvt = cut2_acc.gvt.load(std::memory_order_relaxed);
+      while(lvt < gvt && !cut2_acc.gvt.compare_exchange_weak(gvt, lvt, std::memory_order_relaxed));
+
+      cut2_acc.sum1.fetch_add(rxs.sum1, std::memory_order_relaxed);
+      cut2_acc.sum2.fetch_add(rxs.sum2, std::memory_order_relaxed);
+    }
+
+    if(incoming != 1 + cut2_acc.arrived.fetch_add(1, std::memory_order_acq_rel))
+      return;
+
+    cut2_acc.arrived.store(0, std::memory_order_relaxed);
+    lvt = cut2_acc.gvt.exchange(~uint64_t(0), std::memory_order_relaxed);
+    rxs.sum1 = cut2_acc.sum1.exchange(0, std::memory_order_relaxed);
+    rxs.sum2 = cut2_acc.sum2.exchange(0, std::memory_order_relaxed);
+
+    if(proc_me == 0)
+      cut2_down(round, {/*quiesced=*/true, lvt, rxs});
+    else {
+      int parent = deva::process_rank_lo((proc_me-1)/gvt::radix);
+      deva::send(parent, [=]() {
+        cut2_arrive(round, lvt, rxs);
+      });
+    }
+  }
+
+  void cut2_down(uint64_t round, gvt::coll_result res) {
+    const int proc_me = deva::process_me();
+
+    for(int kid = proc_child_lb(proc_me); kid < proc_child_ub(proc_me); kid++) {
+      deva::send(deva::process_rank_lo(kid), [=]() {
+        cut2_down(round, res);
+      });
+    }
+
+    // every rank of the process is past this round's tag, recycle its counts
+    gvt::bcast_counts &bc = gvt::bcast_ring_[round % gvt::tag_ring_n];
+    bc.arrived.store(0, std::memory_order_relaxed);
+    bc.fwd_sent.store(0, std::memory_order_relaxed);
+    bc.fwd_recv.store(0, std::memory_order_relaxed);
+
+    cut2_result = res;
+    cut2_published.store(round, std::memory_order_release);
+  }
+}
@@ -0,0 +1,170 @@
+// The forwarded API this header is implementing.
+#include <devastator/gvt.hxx>
+
+#ifndef _e3b87c15a0d94f6e9c2b4d7a18f05c63
+#define _e3b87c15a0d94f6e9c2b4d7a18f05c63
+
+namespace deva {
+  namespace gvt {
+    struct coll_result {
+      bool quiesced; // always
+      std::uint64_t gvt;
+      reducibles rxs;
+    };
+
+    // a round is in one phase at a time
+    enum class phase_t: std::uint8_t {
+      idle,     // nothing in flight
+      cut1,     // first cut reducing
+      owed,     // waiting on messages owed to us
+      cut2      // second cut reducing
+    };
+
+    extern __thread std::uint64_t round_begun_, round_seen_;
+    extern __thread phase_t phase_;
+    extern __thread bool coll_ended_;
+    extern __thread coll_result coll_last_;
+    extern __thread std::uint64_t epoch_gvt_, epoch_gvt_prev_;
+
+    // Messages are tagged with the round current at their send plus one, so
+    // tag r is white to round r. Counts are kept per tag modulo `tag_ring_n`,
+    // at most three tags are ever live at a rank.
+    constexpr int tag_ring_n = 4;
+    extern __thread std::uint32_t send_open_to_[deva::rank_n];
+    extern __thread std::uint64_t bcast_open_;
+    extern __thread std::uint64_t send_lvt_, recv_white_lvt_;
+    extern __thread std::uint64_t recv_ring_[tag_ring_n];
+
+    // process wide counts of bcasts arrived and their forwards to local ranks
+    struct alignas(64) bcast_counts {
+      std::atomic<std::uint64_t> arrived{0};
+      std::atomic<std::uint64_t> fwd_sent{0}, fwd_recv{0};
+    };
+    extern bcast_counts bcast_ring_[tag_ring_n];
+
+    void advance_slow_();
+
+    inline void count_recv_(std::uint64_t e, std::uint64_t t) {
+      DEVA_ASSERT(e <= round_begun_ + 2);
+      recv_ring_[e % tag_ring_n] += 1;
+      if(e <= round_begun_)
+        recv_white_lvt_ = std::min(recv_white_lvt_, t);
+    }
+  }
+
+  inline void gvt::advance() {
+    coll_ended_ = false;
+    if(phase_ != phase_t::idle)
+      advance_slow_();
+  }
+
+  inline bool gvt::coll_can_begin() {
+    return phase_ == phase_t::idle;
+  }
+
+  inline int gvt::coll_in_flight() {
+    return int(round_begun_ - round_seen_);
+  }
+
+  inline bool gvt::coll_ended() {
+    return coll_ended_;
+  }
+
+  inline gvt::reducibles gvt::coll_reducibles() {
+    return coll_last_.rxs;
+  }
+
+  inline bool gvt::coll_was_epoch() {
+    return coll_last_.quiesced;
+  }
+
+  inline std::uint64_t gvt::epoch_gvt() {
+    return epoch_gvt_;
+  }
+
+  inline std::uint64_t gvt::epoch_gvt_agreed() {
+    return epoch_gvt_prev_;
+  }
+
+  inline int gvt::coll_until_agreed() {
+    return -coll_in_flight();
+  }
+
+  inline std::uint64_t gvt::epoch_sending() {
+    return round_begun_ + 1;
+  }
+
+  inline std::uint64_t gvt::epoch_settled() {
+    return round_seen_;
+  }
+
+  template<typename Fn, typename ...Arg>
+  void gvt::send(int rank, std::uint64_t t, Fn &&fn, Arg &&...arg) {
+    gvt::send(rank, cmaybe3, t, static_cast<Fn&&>(fn), static_cast<Arg&&>(arg)...);
+  }
+
+  template<bool3 local, typename Fn1, typename ...Arg>
+  void gvt::send(int rank, cbool3<local> local1, std::uint64_t t, Fn1 &&fn, Arg &&...arg) {
+    using Fn = typename std::decay<Fn1>::type;
+    DEVA_ASSERT(epoch_gvt_ <= t);
+
+    std::uint64_t e = round_begun_ + 1;
+    send_open_to_[rank] += 1;
+    send_lvt_ = std::min(send_lvt_, t);
+
+    deva::send(rank, local1,
+      [=](Fn &&fn, typename std::decay<Arg>::type &&...arg) {
+        DEVA_ASSERT(epoch_gvt_ <= t);
+        count_recv_(e, t);
+
+        static_cast<Fn&&>(fn)(static_cast<typename std::decay<Arg>::type&&>(arg)...);
+      },
+      static_cast<Fn1&&>(fn), static_cast<Arg&&>(arg)...
+    );
+  }
+
+  // Counts are owed per destination, and our tag may already be cut before
+  // the message is passed on, so forwards go under the open tag.
+  template<bool3 local, typename Fn1, typename ...Arg>
+  void gvt::forward(int rank, cbool3<local> local1, std::uint64_t t, Fn1 &&fn, Arg &&...arg) {
+    gvt::send(rank, local1, t, static_cast<Fn1&&>(fn), static_cast<Arg&&>(arg)...);
+  }
+
+  template<typename ProcFn1>
+  void gvt::bcast_procs(std::uint64_t t_lb, std::int32_t/*credits*/, ProcFn1 &&proc_fn) {
+    using ProcFn = typename std::decay<ProcFn1>::type;
+    DEVA_ASSERT(epoch_gvt_ <= t_lb);
+
+    // counted once per process it arrives at, not by credits
+    std::uint64_t e = round_begun_ + 1;
+    bcast_open_ += 1;
+    send_lvt_ = std::min(send_lvt_, t_lb);
+
+    deva::bcast_procs(
+      deva::bind(
+        [=](ProcFn &&proc_fn1) {
+          bcast_counts &bc = bcast_ring_[e % tag_ring_n];
+
+          proc_fn1(/*run_at_rank*/[&](int rank, auto fn) {
+            bc.fwd_sent.fetch_add(1, std::memory_order_relaxed);
+
+            deva::send_local(rank,
+              [=, &bc, fn1(std::move(fn))]() {
+                DEVA_ASSERT(epoch_gvt_ <= t_lb);
+
+                fn1();
+                if(e <= round_begun_)
+                  recv_white_lvt_ = std::min(recv_white_lvt_, t_lb);
+                bc.fwd_recv.fetch_add(1, std::memory_order_release);
+              }
+            );
+          });
+
+          bc.arrived.fetch_add(1, std::memory_order_release);
+        },
+        static_cast<ProcFn1&&>(proc_fn)
+      )
+    );
+  }
+} // namespace deva
+#endif
@@ -0,0 +1,304 @@
+#ifndef _7d1c0b6e4a2f4f0b9b61e2d5a8c3f190
+#define _7d1c0b6e4a2f4f0b9b61e2d5a8c3f190
+
+#include <devastator/diagnostic.hxx>
+#include <devastator/utility.hxx>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace deva {
+  /* intrusive_calendar_queue: A calendar queue (Brown '88) with the same
+   * intrusive contract as `intrusive_min_heap` so the two can be swapped. Items
+   * live in a dense slot array (giving `at(i)` and `size()` identical meaning),
+   * `ix_of(x)` holds the item's slot, and each bucket is a doubly linked list
+   * threaded through the slots. `prio_of(x)` is the integral priority used to
+   * pick a bucket, `key_of(x)` gives the total order amongst items (ties in
+   * `prio_of` are broken by `key_of`).
+   *
+   * Insert and erase are O(1). Popping the least scans just the current bucket
+   * which, given the bucket width is re-estimated upon each resize, holds a
+   * small constant number of items on average.
+   */
+  template<typename T, typename Key,
+           int&(&ix_of)(T), Key(&key_of)(T), std::uint64_t(&prio_of)(T)>
+  class intrusive_calendar_queue {
+    struct slot {
+      T x;
+      int prev, next; // bucket list links, -1 terminated
+    };
+
+    int n_ = 0, cap_ = 0;
+    slot *slots_ = nullptr;
+
+    int bkt_n_ = 0; // always pow2 or zero
+    int *bkt_head_ = nullptr;
+    int wbits_ = 63; // log2 of bucket width
+
+    int least_ = -1; // slot of least item or -1 if empty
+    std::uint64_t day_ = 0; // prio_of(least)>>wbits_ (when non-empty)
+
+  public:
+    intrusive_calendar_queue() = default;
+    intrusive_calendar_queue(intrusive_calendar_queue const&) = delete;
+    intrusive_calendar_queue(intrusive_calendar_queue &&that) {
+      *this = static_cast<intrusive_calendar_queue&&>(that);
+    }
+    intrusive_calendar_queue& operator=(intrusive_calendar_queue &&that) {
+      std::swap(this->n_, that.n_);
+      std::swap(this->cap_, that.cap_);
+      std::swap(this->slots_, that.slots_);
+      std::swap(this->bkt_n_, that.bkt_n_);
+      std::swap(this->bkt_head_, that.bkt_head_);
+      std::swap(this->wbits_, that.wbits_);
+      std::swap(this->least_, that.least_);
+      std::swap(this->day_, that.day_);
+      return *this;
+    }
+    ~intrusive_calendar_queue() {
+      clear();
+    }
+
+    int size() const { return n_; }
+
+    T const& at(int i) const {
+      return slots_[i].x;
+    }
+
+    Key least_key() const {
+      return key_of(slots_[least_].x);
+    }
+    Key least_key_or(Key otherwise) const {
+      return n_ == 0 ? otherwise : key_of(slots_[least_].x);
+    }
+
+    T peek_least() const {
+      return slots_[least_].x;
+    }
+    T peek_least_or(T otherwise) const {
+      return n_ == 0 ? otherwise : slots_[least_].x;
+    }
+
+    void insert(T x);
+    T pop_least();
+    void erase(T x);
+    void clear();
+
+  private:
+    int bucket_of(std::uint64_t prio) const {
+      return int((prio >> wbits_) & std::uint64_t(bkt_n_-1));
+    }
+    void link(int s);
+    void unlink(int s);
+    void remove_slot(int s);
+    void find_least();
+    void rebucket(int bkt_n1);
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+
+  template<typename T, typename Key, int&(&ix_of)(T), Key(&key_of)(T), std::uint64_t(&prio_of)(T)>
+  void intrusive_calendar_queue<T,Key,ix_of,key_of,prio_of>::link(int s) {
+    int b = bucket_of(prio_of(slots_[s].x));
+    int h = bkt_head_[b];
+    slots_[s].prev = -1;
+    slots_[s].next = h;
+    if(h != -1)
+      slots_[h].prev = s;
+    bkt_head_[b] = s;
+  }
+
+  template<typename T, typename Key, int&(&ix_of)(T), Key(&key_of)(T), std::uint64_t(&prio_of)(T)>
+  void intrusive_calendar_queue<T,Key,ix_of,key_of,prio_of>::unlink(int s) {
+    int p = slots_[s].prev;
+    int q = slots_[s].next;
+    if(p != -1)
+      slots_[p].next = q;
+    else
+      bkt_head_[bucket_of(prio_of(slots_[s].x))] = q;
+    if(q != -1)
+      slots_[q].prev = p;
+  }
+
+  template<typename T, typename Key, int&(&ix_of)(T), Key(&key_of)(T), std::uint64_t(&prio_of)(T)>
+  void intrusive_calendar_queue<T,Key,ix_of,key_of,prio_of>::insert(T x) {
+    if(n_ == cap_) {
+      int cap1 = cap_ == 0 ? 4 : 2*cap_;
+      slot *slots1 = new slot[cap1];
+      std::copy(slots_, slots_ + n_, slots1);
+      delete[] slots_;
+      slots_ = slots1;
+      cap_ = cap1;
+    }
+
+    int s = n_++;
+    slots_[s].x = x;
+    ix_of(x) = s;
+
+    if(bkt_n_ == 0) {
+      bkt_n_ = 1;
+      bkt_head_ = new int[1]{-1};
+    }
+    link(s);
+
+    if(least_ == -1 || key_of(x) < key_of(slots_[least_].x)) {
+      least_ = s;
+      day_ = prio_of(x) >> wbits_;
+    }
+
+    if(n_ > 2*bkt_n_)
+      rebucket(2*bkt_n_);
+  }
+
+  template<typename T, typename Key, int&(&ix_of)(T), Key(&key_of)(T), std::uint64_t(&prio_of)(T)>
+  T intrusive_calendar_queue<T,Key,ix_of,key_of,prio_of>::pop_least() {
+    T ans = slots_[least_].x;
+    remove_slot(least_);
+    ix_of(ans) = -1;
+    return ans;
+  }
+
+  template<typename T, typename Key, int&(&ix_of)(T), Key(&key_of)(T), std::uint64_t(&prio_of)(T)>
+  void intrusive_calendar_queue<T,Key,ix_of,key_of,prio_of>::erase(T x) {
+    remove_slot(ix_of(x));
+  }
+
+  template<typename T, typename Key, int&(&ix_of)(T), Key(&key_of)(T), std::uint64_t(&prio_of)(T)>
+  void intrusive_calendar_queue<T,Key,ix_of,key_of,prio_of>::remove_slot(int s) {
+    DEVA_ASSERT(0 <= s && s < n_);
+    bool was_least = s == least_;
+    if(was_least)
+      least_ = -1;
+
+    unlink(s);
+
+    // keep slots dense by moving the last one into the hole
+    int last = --n_;
+    if(s != last) {
+      slot *m = &slots_[last];
+      slots_[s] = *m;
+      ix_of(slots_[s].x) = s;
+      if(m->prev != -1)
+        slots_[m->prev].next = s;
+      else
+        bkt_head_[bucket_of(prio_of(m->x))] = s;
+      if(m->next != -1)
+        slots_[m->next].prev = s;
+      if(least_ == last)
+        least_ = s;
+    }
+
+    if(n_ == 0)
+      return; // retain storage, cds routinely drain and refill
+    else if(2*n_ < bkt_n_)
+      rebucket(bkt_n_/2);
+    else if(was_least)
+      find_least();
+  }
+
+  template<typename T, typename Key, int&(&ix_of)(T), Key(&key_of)(T), std::uint64_t(&prio_of)(T)>
+  void intrusive_calendar_queue<T,Key,ix_of,key_of,prio_of>::find_least() {
+    // Walk the calendar from the last known day. Nothing can precede `day_`
+    // since inserts ahead of it move it back.
+    std::uint64_t day = day_;
+
+    for(int i=0; i < bkt_n_; i++, day++) {
+      int best = -1;
+      for(int s = bkt_head_[int(day & std::uint64_t(bkt_n_-1))]; s != -1; s = slots_[s].next) {
+        if(prio_of(slots_[s].x) >> wbits_ == day) {
+          if(best == -1 || key_of(slots_[s].x) < key_of(slots_[best].x))
+            best = s;
+        }
+      }
+
+      if(best != -1) {
+        least_ = best;
+        day_ = day;
+        return;
+      }
+    }
+
+    // A whole year was empty, fall back to direct search.
+    int best = 0;
+    for(int s=1; s < n_; s++) {
+      if(key_of(slots_[s].x) < key_of(slots_[best].x))
+        best = s;
+    }
+    least_ = best;
+    day_ = prio_of(slots_[best].x) >> wbits_;
+  }
+
+  template<typename T, typename Key, int&(&ix_of)(T), Key(&key_of)(T), std::uint64_t(&prio_of)(T)>
+  void intrusive_calendar_queue<T,Key,ix_of,key_of,prio_of>::rebucket(int bkt_n1) {
+    // Estimate a bucket width of about three times the mean separation
+    // amongst the earliest items, ignoring outlying gaps.
+    constexpr int sample_n = 32;
+    std::uint64_t width = std::uint64_t(1)<<63;
+
+    if(n_ >= 2) {
+      std::vector<std::uint64_t> prios(n_);
+      for(int s=0; s < n_; s++)
+        prios[s] = prio_of(slots_[s].x);
+
+      int k = std::min(n_, sample_n);
+      std::nth_element(prios.begin(), prios.begin() + (k-1), prios.end());
+      std::sort(prios.begin(), prios.begin() + k);
+
+      std::uint64_t sum = prios[k-1] - prios[0];
+      std::uint64_t avg = sum/(k-1);
+      std::uint64_t sum1 = 0;
+      int gap_n = 0;
+      for(int i=1; i < k; i++) {
+        std::uint64_t gap = prios[i] - prios[i-1];
+        if(gap <= 2*avg) {
+          sum1 += gap;
+          gap_n += 1;
+        }
+      }
+
+      if(gap_n != 0 && sum1 != 0)
+        width = 3*(sum1/gap_n) + 1;
+      else if(sum != 0)
+        width = 3*avg + 1;
+    }
+
+    int wbits1 = std::min(63, log2up(width));
+
+    delete[] bkt_head_;
+    bkt_n_ = bkt_n1;
+    bkt_head_ = new int[bkt_n1];
+    std::fill(bkt_head_, bkt_head_ + bkt_n1, -1);
+    wbits_ = wbits1;
+
+    for(int s=0; s < n_; s++)
+      link(s);
+
+    if(least_ != -1)
+      day_ = prio_of(slots_[least_].x) >> wbits_;
+    else if(n_ != 0) {
+      int best = 0;
+      for(int s=1; s < n_; s++) {
+        if(key_of(slots_[s].x) < key_of(slots_[best].x))
+          best = s;
+      }
+      least_ = best;
+      day_ = prio_of(slots_[best].x) >> wbits_;
+    }
+  }
+
+  template<typename T, typename Key, int&(&ix_of)(T), Key(&key_of)(T), std::uint64_t(&prio_of)(T)>
+  void intrusive_calendar_queue<T,Key,ix_of,key_of,prio_of>::clear() {
+    n_ = 0;
+    cap_ = 0;
+    delete[] slots_;
+    slots_ = nullptr;
+    bkt_n_ = 0;
+    delete[] bkt_head_;
+    bkt_head_ = nullptr;
+    wbits_ = 63;
+    least_ = -1;
+    day_ = 0;
+  }
+} // namespace deva
+#endif
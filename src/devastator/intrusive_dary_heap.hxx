@@ -0,0 +1,284 @@
+#ifndef _33d036d3b62242fe877cf21f0a726533
+#define _33d036d3b62242fe877cf21f0a726533
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace deva {
+  namespace detail {
+    // Reduces the `2*w` keys at `k` (and their lane indices `ix`) pairwise in
+    // vector registers until the least key is at `k[0]` and its lane at
+    // `ix[0]`. Ties keep the lower lane.
+    template<int w>
+    struct dary_least {
+      typedef std::uint64_t vec __attribute__((vector_size(8*w)));
+
+      static void reduce(std::uint64_t *k, std::uint64_t *ix) {
+        vec ka, kb, ia, ib;
+        std::memcpy(&ka, k, sizeof(vec));
+        std::memcpy(&kb, k + w, sizeof(vec));
+        std::memcpy(&ia, ix, sizeof(vec));
+        std::memcpy(&ib, ix + w, sizeof(vec));
+        vec lt = (vec)(kb < ka); // all ones where b is less
+        ka = (kb & lt) | (ka & ~lt);
+        ia = (ib & lt) | (ia & ~lt);
+        std::memcpy(k, &ka, sizeof(vec));
+        std::memcpy(ix, &ia, sizeof(vec));
+        dary_least<w/2>::reduce(k, ix);
+      }
+    };
+
+    template<>
+    struct dary_least<0> {
+      static void reduce(std::uint64_t*, std::uint64_t*) {}
+    };
+  }
+
+  /* intrusive_dary_heap: Drop-in for `intrusive_min_heap` (same intrusive
+   * contract and members) as a `d`-ary heap. Keys are cached in an array
+   * parallel to the items and offset so each sibling group is contiguous and
+   * `d` aligned. When `Key` is `std::uint64_t` the slack past the last item
+   * holds the greatest key and finding the least child is a fixed tree of
+   * `log2(d)` vector compares, so each level of a sift down is one load and
+   * reduce regardless of how many children exist. Otherwise children are
+   * scanned in scalar.
+   */
+  template<typename T, typename Key, int&(&ix_of)(T), Key(&key_of)(T), int d=4>
+  class intrusive_dary_heap {
+    static_assert(d >= 2 && (d & (d-1)) == 0, "Arity must be a power of two.");
+
+    static constexpr bool simd = std::is_same<Key, std::uint64_t>::value;
+    static constexpr int off = d-1; // keys_[i + off] is the key of buf_[i]
+
+    int n_ = 0, cap_ = 0;
+    T *buf_ = nullptr;
+    Key *keys_ = nullptr;
+
+  public:
+    intrusive_dary_heap() = default;
+    intrusive_dary_heap(intrusive_dary_heap const&) = delete;
+    intrusive_dary_heap(intrusive_dary_heap &&that) {
+      this->n_ = that.n_;
+      this->cap_ = that.cap_;
+      this->buf_ = that.buf_;
+      this->keys_ = that.keys_;
+      that.n_ = 0;
+      that.cap_ = 0;
+      that.buf_ = nullptr;
+      that.keys_ = nullptr;
+    }
+    ~intrusive_dary_heap() {
+      delete[] buf_;
+      delete[] keys_;
+    }
+
+    void resize(int cap);
+
+  private:
+    void put(int ix, T x, Key key) {
+      buf_[ix] = x;
+      keys_[ix + off] = key;
+      ix_of(x) = ix;
+    }
+
+    void pad(int ix, std::true_type) {
+      keys_[ix + off] = std::numeric_limits<std::uint64_t>::max();
+    }
+    void pad(int, std::false_type) {}
+
+    void push_back(T x) {
+      if(n_ + 1 > cap_)
+        resize(cap_ == 0 ? d : 2*cap_);
+      ix_of(x) = n_;
+      buf_[n_++] = x;
+    }
+
+    T pop_back() {
+      T ans = buf_[--n_];
+      pad(n_, std::integral_constant<bool, simd>());
+      if(n_ <= cap_/8 && cap_ >= 16)
+        resize(cap_/2);
+      return ans;
+    }
+
+    // least of the children beginning at `c`, which must be < `n_`
+    int least_child(int c, std::true_type) const {
+      std::uint64_t k[d], ix[d];
+      std::memcpy(k, keys_ + c + off, sizeof(k));
+      for(int i=0; i < d; i++)
+        ix[i] = i;
+      detail::dary_least<d/2>::reduce(k, ix);
+      return c + int(ix[0]);
+    }
+    int least_child(int c, std::false_type) const {
+      int c_end = std::min(c + d, n_);
+      int least = c;
+      for(int i=c+1; i < c_end; i++) {
+        if(keys_[i + off] < keys_[least + off])
+          least = i;
+      }
+      return least;
+    }
+
+    bool decreased(int ix, T x, Key key);
+    void increased(int ix, T x, Key key);
+
+    template<typename Fn>
+    void increase_all_less(int ix, Key key, Fn &fn);
+
+  public:
+    int size() const { return this->n_; }
+
+    T const& at(int i) const {
+      return this->buf_[i];
+    }
+
+    Key least_key() const {
+      return keys_[off];
+    }
+    Key least_key_or(Key otherwise) const {
+      return this->n_ == 0 ? otherwise : keys_[off];
+    }
+
+    T peek_least() const {
+      return this->buf_[0];
+    }
+    T peek_least_or(T otherwise) const {
+      return this->n_ == 0 ? otherwise : this->buf_[0];
+    }
+
+    void insert(T x) {
+      this->push_back(x);
+      this->decreased(this->n_-1, x, key_of(x));
+    }
+
+    T pop_least() {
+      T ans = this->buf_[0];
+      ix_of(ans) = -1;
+      T tmp = this->pop_back();
+      if(this->n_ != 0)
+        this->increased(0, tmp, key_of(tmp));
+      return ans;
+    }
+
+    void erase(T x) {
+      int ix = ix_of(x);
+      T tmp1 = this->pop_back();
+
+      if(ix != this->n_) {
+        Key key1 = key_of(tmp1);
+        if(!(keys_[ix + off] < key1))
+          this->decreased(ix, tmp1, key1);
+        else
+          this->increased(ix, tmp1, key1);
+      }
+    }
+
+    void increased(T x) {
+      this->increased(ix_of(x), x, key_of(x));
+    }
+    void increased(T x, Key key) {
+      this->increased(ix_of(x), x, key);
+    }
+
+    void decreased(T x) {
+      this->decreased(ix_of(x), x, key_of(x));
+    }
+    void decreased(T x, Key key) {
+      this->decreased(ix_of(x), x, key);
+    }
+
+    void changed(T x) {
+      int ix = ix_of(x);
+      Key key = key_of(x);
+      if(!this->decreased(ix, x, key))
+        this->increased(ix, x, key);
+    }
+
+    void clear() {
+      n_ = 0;
+      cap_ = 0;
+      delete[] buf_;
+      delete[] keys_;
+      buf_ = nullptr;
+      keys_ = nullptr;
+    }
+
+    template<typename Fn>
+    void increase_all_less(Key key, Fn &&fn) {
+      this->increase_all_less(0, key, fn);
+    }
+  };
+
+  template<typename T, typename Key, int&(&ix_of)(T), Key(&key_of)(T), int d>
+  void intrusive_dary_heap<T,Key,ix_of,key_of,d>::resize(int cap1) {
+    T *buf1 = cap1 ? new T[cap1] : nullptr;
+    // room for the offset and one whole sibling group past the end
+    Key *keys1 = cap1 ? new Key[cap1 + off + d] : nullptr;
+    std::copy(buf_, buf_ + n_, buf1);
+    if(keys_ != nullptr)
+      std::copy(keys_, keys_ + (n_ + off), keys1);
+    delete[] buf_;
+    delete[] keys_;
+    buf_ = buf1;
+    keys_ = keys1;
+    cap_ = cap1;
+    for(int i=n_; i < cap1 + d; i++)
+      pad(i, std::integral_constant<bool, simd>());
+  }
+
+  template<typename T, typename Key, int&(&ix_of)(T), Key(&key_of)(T), int d>
+  void intrusive_dary_heap<T,Key,ix_of,key_of,d>::increased(int ix, T x, Key key) {
+    // sift toward leaves
+    int n = this->n_;
+
+    while(true) {
+      int c = d*ix + 1;
+      if(c >= n)
+        break;
+      int ix1 = least_child(c, std::integral_constant<bool, simd>());
+      if(!(keys_[ix1 + off] < key))
+        break;
+      put(ix, buf_[ix1], keys_[ix1 + off]);
+      ix = ix1;
+    }
+
+    put(ix, x, key);
+  }
+
+  template<typename T, typename Key, int&(&ix_of)(T), Key(&key_of)(T), int d>
+  bool intrusive_dary_heap<T,Key,ix_of,key_of,d>::decreased(int ix, T x, Key key) {
+    // sift toward root
+    bool changed = false;
+
+    while(ix != 0) {
+      int p = (ix-1)/d;
+
+      if(key < keys_[p + off]) {
+        changed = true;
+        put(ix, buf_[p], keys_[p + off]);
+        ix = p;
+      }
+      else
+        break;
+    }
+
+    put(ix, x, key);
+    return changed;
+  }
+
+  template<typename T, typename Key, int&(&ix_of)(T), Key(&key_of)(T), int d>
+  template<typename Fn>
+  void intrusive_dary_heap<T,Key,ix_of,key_of,d>::increase_all_less(int ix, Key key, Fn &fn) {
+    if(ix < n_ && keys_[ix + off] < key) {
+      T x = fn(buf_[ix]);
+      for(int c = d*ix + 1; c < d*ix + 1 + d; c++)
+        this->increase_all_less(c, key, fn);
+      this->increased(ix, x, key_of(x));
+    }
+  }
+} // namespace deva
+#endif
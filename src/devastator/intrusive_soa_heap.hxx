@@ -0,0 +1,204 @@
+#ifndef _5f0d7a2c93e84b1ea6c4f8b2d17e0a39
+#define _5f0d7a2c93e84b1ea6c4f8b2d17e0a39
+
+#include <devastator/diagnostic.hxx>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace deva {
+  /* intrusive_soa_heap: A binary min heap with the intrusive contract of
+   * `intrusive_calendar_queue` (so it swaps in for `intrusive_min_heap` where
+   * only that subset is used), laid out as structure of arrays. Items live in
+   * a dense slot array giving `at(i)` and `size()`, and `ix_of(x)` holds the
+   * item's slot, which only changes when the last slot is moved into a hole.
+   * The heap itself is an array of just keys and slots, with each slot's heap
+   * position kept in a separate array. Sifting therefor compares and moves
+   * only dense keys and indices, never touching the items (or what they point
+   * to) the way writing `ix_of` on every move does.
+   */
+  template<typename T, typename Key, int&(&ix_of)(T), Key(&key_of)(T)>
+  class intrusive_soa_heap {
+    struct entry {
+      Key key;
+      int slot;
+    };
+
+    int n_ = 0, cap_ = 0;
+    entry *heap_ = nullptr; // by heap position
+    T *items_ = nullptr; // by slot
+    int *pos_ = nullptr; // by slot
+
+  public:
+    intrusive_soa_heap() = default;
+    intrusive_soa_heap(intrusive_soa_heap const&) = delete;
+    intrusive_soa_heap(intrusive_soa_heap &&that) {
+      *this = static_cast<intrusive_soa_heap&&>(that);
+    }
+    intrusive_soa_heap& operator=(intrusive_soa_heap &&that) {
+      std::swap(this->n_, that.n_);
+      std::swap(this->cap_, that.cap_);
+      std::swap(this->heap_, that.heap_);
+      std::swap(this->items_, that.items_);
+      std::swap(this->pos_, that.pos_);
+      return *this;
+    }
+    ~intrusive_soa_heap() {
+      clear();
+    }
+
+    int size() const { return n_; }
+
+    T const& at(int i) const {
+      return items_[i];
+    }
+
+    Key least_key() const {
+      return heap_[0].key;
+    }
+    Key least_key_or(Key otherwise) const {
+      return n_ == 0 ? otherwise : heap_[0].key;
+    }
+
+    T peek_least() const {
+      return items_[heap_[0].slot];
+    }
+    T peek_least_or(T otherwise) const {
+      return n_ == 0 ? otherwise : items_[heap_[0].slot];
+    }
+
+    void insert(T x);
+    T pop_least();
+    void erase(T x);
+    void clear();
+
+  private:
+    void resize(int cap1);
+    // settle `x` starting from heap position `ix`
+    void sift_up(int ix, entry x);
+    void sift_down(int ix, entry x);
+    // remove heap position `ix`, returns the slot that was there
+    int remove_at(int ix);
+    // vacate slot `s` by moving the last slot into it
+    void free_slot(int s);
+  };
+
+  template<typename T, typename Key, int&(&ix_of)(T), Key(&key_of)(T)>
+  void intrusive_soa_heap<T,Key,ix_of,key_of>::resize(int cap1) {
+    entry *heap1 = new entry[cap1];
+    T *items1 = new T[cap1];
+    int *pos1 = new int[cap1];
+    std::copy(heap_, heap_ + n_, heap1);
+    std::copy(items_, items_ + n_, items1);
+    std::copy(pos_, pos_ + n_, pos1);
+    delete[] heap_;
+    delete[] items_;
+    delete[] pos_;
+    heap_ = heap1;
+    items_ = items1;
+    pos_ = pos1;
+    cap_ = cap1;
+  }
+
+  template<typename T, typename Key, int&(&ix_of)(T), Key(&key_of)(T)>
+  void intrusive_soa_heap<T,Key,ix_of,key_of>::clear() {
+    delete[] heap_;
+    delete[] items_;
+    delete[] pos_;
+    heap_ = nullptr;
+    items_ = nullptr;
+    pos_ = nullptr;
+    n_ = 0;
+    cap_ = 0;
+  }
+
+  template<typename T, typename Key, int&(&ix_of)(T), Key(&key_of)(T)>
+  void intrusive_soa_heap<T,Key,ix_of,key_of>::sift_up(int ix, entry x) {
+    while(ix != 0) {
+      int p = (ix-1)/2;
+      if(!(x.key < heap_[p].key))
+        break;
+      heap_[ix] = heap_[p];
+      pos_[heap_[ix].slot] = ix;
+      ix = p;
+    }
+    heap_[ix] = x;
+    pos_[x.slot] = ix;
+  }
+
+  template<typename T, typename Key, int&(&ix_of)(T), Key(&key_of)(T)>
+  void intrusive_soa_heap<T,Key,ix_of,key_of>::sift_down(int ix, entry x) {
+    int n = n_;
+    while(true) {
+      int k = 2*ix + 1;
+      if(k >= n)
+        break;
+      if(k+1 < n)
+        k += int(heap_[k+1].key < heap_[k].key);
+      if(!(heap_[k].key < x.key))
+        break;
+      heap_[ix] = heap_[k];
+      pos_[heap_[ix].slot] = ix;
+      ix = k;
+    }
+    heap_[ix] = x;
+    pos_[x.slot] = ix;
+  }
+
+  template<typename T, typename Key, int&(&ix_of)(T), Key(&key_of)(T)>
+  int intrusive_soa_heap<T,Key,ix_of,key_of>::remove_at(int ix) {
+    int slot = heap_[ix].slot;
+    int last = --n_;
+    if(ix != last) {
+      entry x = heap_[last];
+      if(ix != 0 && x.key < heap_[(ix-1)/2].key)
+        sift_up(ix, x);
+      else
+        sift_down(ix, x);
+    }
+    return slot;
+  }
+
+  template<typename T, typename Key, int&(&ix_of)(T), Key(&key_of)(T)>
+  void intrusive_soa_heap<T,Key,ix_of,key_of>::free_slot(int s) {
+    // `n_` already counts one less item than there are slots
+    int last = n_;
+    if(s != last) {
+      T y = items_[last];
+      items_[s] = y;
+      ix_of(y) = s;
+      pos_[s] = pos_[last];
+      heap_[pos_[s]].slot = s;
+    }
+  }
+
+  template<typename T, typename Key, int&(&ix_of)(T), Key(&key_of)(T)>
+  void intrusive_soa_heap<T,Key,ix_of,key_of>::insert(T x) {
+    if(n_ == cap_)
+      resize(cap_ == 0 ? 4 : 2*cap_);
+    int s = n_++;
+    items_[s] = x;
+    ix_of(x) = s;
+    sift_up(s, entry{key_of(x), s});
+  }
+
+  template<typename T, typename Key, int&(&ix_of)(T), Key(&key_of)(T)>
+  T intrusive_soa_heap<T,Key,ix_of,key_of>::pop_least() {
+    DEVA_ASSERT(n_ != 0);
+    int s = remove_at(0);
+    T x = items_[s];
+    ix_of(x) = -1;
+    free_slot(s);
+    return x;
+  }
+
+  template<typename T, typename Key, int&(&ix_of)(T), Key(&key_of)(T)>
+  void intrusive_soa_heap<T,Key,ix_of,key_of>::erase(T x) {
+    int s = ix_of(x);
+    DEVA_ASSERT(0 <= s && s < n_);
+    remove_at(pos_[s]);
+    ix_of(x) = -1;
+    free_slot(s);
+  }
+} // namespace deva
+#endif
@@ -503,7 +503,8 @@ namespace {
   void arena_dealloc_remote(arena *a, frobj *o) {
     int t = a->owner_id;
 
-    if(t >= 0) {
+    // threads outside the world (helpers) can't message the owner
+    if(t >= 0 && threads::thread_me() >= 0) {
       auto rbin = &remote_bins[t];
       
       int bin = bin_of(a, o);
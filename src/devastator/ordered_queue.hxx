@@ -0,0 +1,276 @@
+#ifndef _860b0befaebb40f69336111fbaa2f759
+#define _860b0befaebb40f69336111fbaa2f759
+
+#include <devastator/diagnostic.hxx>
+#include <devastator/queue.hxx>
+
+#include <algorithm>
+
+namespace deva {
+  // A queue kept sorted by `T`'s `<`, stored as a deque of fixed size chunks.
+  // Ordered insertion and search binary search the chunks by their last
+  // element and then within one chunk, so only `chunk_n` elements move per
+  // insert. The backward index returned is found by summing the sizes of the
+  // chunks behind, which is bounded by that index (what a pdes rollback walks
+  // anyway). Positional access keeps a cursor to the last chunk touched so
+  // walking forwards or backwards one element at a time is amortized O(1).
+  // Equal elements keep their insertion order.
+  template<typename T, int chunk_n=64>
+  class ordered_queue {
+    struct chunk {
+      int beg, end;
+      T x[chunk_n];
+
+      int size() const { return end - beg; }
+      T const& front() const { return x[beg]; }
+      T const& back() const { return x[end-1]; }
+    };
+
+    deva::queue<chunk*> chunks_;
+    int n_ = 0;
+    chunk *spare_ = nullptr;
+    // chunk index and forward index of its first element, k<0 when invalid
+    mutable int cur_k_ = -1, cur_base_ = 0;
+
+  public:
+    ordered_queue() = default;
+    ordered_queue(ordered_queue const&) = delete;
+    ordered_queue(ordered_queue &&that) noexcept:
+      chunks_(std::move(that.chunks_)) {
+      this->n_ = that.n_;
+      this->spare_ = that.spare_;
+      that.n_ = 0;
+      that.spare_ = nullptr;
+      that.cur_k_ = -1;
+    }
+    ~ordered_queue() {
+      while(chunks_.size() != 0)
+        delete chunks_.pop_back();
+      delete spare_;
+    }
+
+  private:
+    chunk* new_chunk() {
+      chunk *c = spare_;
+      spare_ = nullptr;
+      if(c == nullptr)
+        c = new chunk;
+      c->beg = 0;
+      c->end = 0;
+      return c;
+    }
+    void free_chunk(chunk *c) {
+      if(spare_ == nullptr)
+        spare_ = c;
+      else
+        delete c;
+    }
+
+    T* slot(int i) const;
+    // first chunk whose last element is not `lt` than `x`
+    template<typename Lt>
+    int chunk_bound(T const &x, Lt lt) const;
+    // number of elements in the chunks behind chunk `k`
+    int size_behind(int k) const;
+    void insert_chunk(int k, chunk *c);
+
+  public:
+    int size() const { return n_; }
+
+    T const& at_forwards(int i) const { return *slot(i); }
+    T& at_forwards(int i) { return *slot(i); }
+
+    T const& at_backwards(int i) const { return *slot(n_-1 - i); }
+    T& at_backwards(int i) { return *slot(n_-1 - i); }
+
+    T front_or(T otherwise) const {
+      return n_ == 0 ? otherwise : chunks_.at_forwards(0)->front();
+    }
+    T back_or(T otherwise) const {
+      return n_ == 0 ? otherwise : chunks_.at_backwards(0)->back();
+    }
+
+    // Inserts after all elements not greater than `x`, returns the number of
+    // elements now behind it (its backward index).
+    int insert(T x);
+
+    // Backward index of the element for which `match` holds. It must be
+    // present and ordered equal to `x`.
+    template<typename Match>
+    int find_backwards(T const &x, Match match) const;
+
+    void chop_back(int n);
+    void chop_front(int n);
+  };
+
+  template<typename T, int chunk_n>
+  T* ordered_queue<T,chunk_n>::slot(int i) const {
+    DEVA_ASSERT(0 <= i && i < n_);
+    int k = cur_k_, base = cur_base_;
+
+    if(k < 0) {
+      if(i < n_/2) {
+        k = 0;
+        base = 0;
+      }
+      else {
+        k = chunks_.size()-1;
+        base = n_ - chunks_.at_forwards(k)->size();
+      }
+    }
+
+    while(i < base) {
+      k -= 1;
+      base -= chunks_.at_forwards(k)->size();
+    }
+    while(base + chunks_.at_forwards(k)->size() <= i) {
+      base += chunks_.at_forwards(k)->size();
+      k += 1;
+    }
+
+    cur_k_ = k;
+    cur_base_ = base;
+    chunk *c = chunks_.at_forwards(k);
+    return &c->x[c->beg + i - base];
+  }
+
+  template<typename T, int chunk_n>
+  template<typename Lt>
+  int ordered_queue<T,chunk_n>::chunk_bound(T const &x, Lt lt) const {
+    int lo = 0, hi = chunks_.size()-1;
+    while(lo < hi) {
+      int mid = (lo + hi)/2;
+      if(lt(chunks_.at_forwards(mid)->back(), x))
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    return lo;
+  }
+
+  template<typename T, int chunk_n>
+  int ordered_queue<T,chunk_n>::size_behind(int k) const {
+    int n = 0;
+    for(int k1 = k+1; k1 < chunks_.size(); k1++)
+      n += chunks_.at_forwards(k1)->size();
+    return n;
+  }
+
+  template<typename T, int chunk_n>
+  void ordered_queue<T,chunk_n>::insert_chunk(int k, chunk *c) {
+    chunks_.push_back(c);
+    for(int k1 = chunks_.size()-1; k1 != k; k1--)
+      chunks_.at_forwards(k1) = chunks_.at_forwards(k1-1);
+    chunks_.at_forwards(k) = c;
+  }
+
+  template<typename T, int chunk_n>
+  int ordered_queue<T,chunk_n>::insert(T x) {
+    cur_k_ = -1;
+    n_ += 1;
+
+    // in order arrivals append
+    if(n_ == 1 || !(x < chunks_.at_backwards(0)->back())) {
+      chunk *c = n_ == 1 ? nullptr : chunks_.at_backwards(0);
+      if(c == nullptr || c->end == chunk_n) {
+        c = new_chunk();
+        chunks_.push_back(c);
+      }
+      c->x[c->end++] = x;
+      return 0;
+    }
+
+    // the last chunk's back is greater than `x` so some chunk's is
+    int k = chunk_bound(x, [](T const &a, T const &b) { return !(b < a); });
+    chunk *c = chunks_.at_forwards(k);
+    int s = int(std::upper_bound(c->x + c->beg, c->x + c->end, x) - c->x);
+    int behind = c->end - s + size_behind(k);
+
+    if(c->beg == 0 && c->end == chunk_n) {
+      // split upper half into a new chunk
+      chunk *c1 = new_chunk();
+      int half = chunk_n/2;
+      std::copy(c->x + half, c->x + chunk_n, c1->x);
+      c1->end = chunk_n - half;
+      c->end = half;
+      insert_chunk(k+1, c1);
+
+      if(s > half) {
+        c = c1;
+        s -= half;
+      }
+    }
+
+    if(c->end != chunk_n) {
+      std::copy_backward(c->x + s, c->x + c->end, c->x + c->end + 1);
+      c->end += 1;
+      c->x[s] = x;
+    }
+    else {
+      std::copy(c->x + c->beg, c->x + s, c->x + c->beg - 1);
+      c->beg -= 1;
+      c->x[s-1] = x;
+    }
+    return behind;
+  }
+
+  template<typename T, int chunk_n>
+  template<typename Match>
+  int ordered_queue<T,chunk_n>::find_backwards(T const &x, Match match) const {
+    DEVA_ASSERT(n_ != 0);
+    int k = chunk_bound(x, [](T const &a, T const &b) { return a < b; });
+    chunk *c = chunks_.at_forwards(k);
+    int s = int(std::lower_bound(c->x + c->beg, c->x + c->end, x) - c->x);
+
+    // scan forward over the equal run
+    while(!match(c->x[s])) {
+      DEVA_ASSERT(!(x < c->x[s]));
+      if(++s == c->end) {
+        c = chunks_.at_forwards(++k);
+        s = c->beg;
+      }
+    }
+
+    int behind = c->end-1 - s + size_behind(k);
+    cur_k_ = k;
+    cur_base_ = n_-1 - behind - (s - c->beg);
+    return behind;
+  }
+
+  template<typename T, int chunk_n>
+  void ordered_queue<T,chunk_n>::chop_back(int n) {
+    DEVA_ASSERT(n <= n_);
+    cur_k_ = -1;
+    n_ -= n;
+    while(n != 0) {
+      chunk *c = chunks_.at_backwards(0);
+      if(c->size() <= n) {
+        n -= c->size();
+        free_chunk(chunks_.pop_back());
+      }
+      else {
+        c->end -= n;
+        n = 0;
+      }
+    }
+  }
+
+  template<typename T, int chunk_n>
+  void ordered_queue<T,chunk_n>::chop_front(int n) {
+    DEVA_ASSERT(n <= n_);
+    cur_k_ = -1;
+    n_ -= n;
+    while(n != 0) {
+      chunk *c = chunks_.at_forwards(0);
+      if(c->size() <= n) {
+        n -= c->size();
+        free_chunk(chunks_.pop_front());
+      }
+      else {
+        c->beg += n;
+        n = 0;
+      }
+    }
+  }
+}
+#endif
@@ -2,16 +2,28 @@
 #include <devastator/gvt.hxx>
 #include <devastator/pdes.hxx>
 #include <devastator/intrusive_map.hxx>
+#include <devastator/intrusive_calendar_queue.hxx>
+#include <devastator/intrusive_dary_heap.hxx>
 #include <devastator/intrusive_min_heap.hxx>
+#include <devastator/intrusive_soa_heap.hxx>
+#include <devastator/ordered_queue.hxx>
 #include <devastator/queue.hxx>
 #include <devastator/os_env.hxx>
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
 #include <utility>
 #include <vector>
 #include <fstream>
+#include <map>
 
 namespace gvt = deva::gvt;
 namespace pdes = deva::pdes;
@@ -22,15 +34,21 @@ using namespace std;
 
 std::ostream* pdes::chitter_io = &std::cout;
 int pdes::chitter_secs = 3;
+int pdes::drain_quantum = deva::os_env<int>("deva_drain_quantum", 1);
+int pdes::drain_quantum_us = deva::os_env<int>("deva_drain_quantum_us", 0);
+int pdes::commit_slice = deva::os_env<int>("deva_commit_slice", 0);
+bool pdes::commit_offload = false;
+std::int64_t pdes::memory_budget = deva::os_env<std::int64_t>("deva_memory_budget", 0);
+bool pdes::cd_steal = false;
 
 constexpr detail::sent_far_record::vtable detail::sent_far_one::the_vtbl;
 
 __thread uint64_t pdes::detail::far_id_bumper;
 uint64_t pdes::detail::seq_id_delta;
+const bool pdes::detail::lazy_cancel = deva::os_env<bool>("deva_lazy_cancel", false);
 
-#if DEBUG
 __thread std::int64_t pdes::detail::live_event_balance = 0;
-#endif
+__thread std::int64_t pdes::detail::live_event_bytes = 0;
 
 namespace {
   const int64_t static_look_dt = deva::os_env<int64_t>("deva_static_look_dt", -1);
@@ -72,22 +90,51 @@ namespace {
     uint64_t calc_look_t_ub(uint64_t gvt, uint64_t t_end);
   };
 
-  inline pair<uint64_t,uint64_t> far_id_time_of(event_on_creator *e) {
-    return {e->far_id, e->time};
+  // Far ids are only unique per home rank (`bcast_procs` numbers each rank's
+  // events from the same base), and migrated cds of several homes may share a
+  // host's `from_far`.
+  using far_key = std::tuple<uint64_t,uint64_t,int32_t>;
+  
+  inline far_key far_id_time_of(event_on_creator *e) {
+    return far_key{e->far_id, e->time, e->far_home};
   }
-  inline size_t far_id_time_hash(pair<uint64_t,uint64_t> const &xy) {
-    return xy.first ^ xy.second;
+  inline size_t far_id_time_hash(far_key const &k) {
+    return std::get<0>(k) ^ std::get<1>(k) ^ size_t(std::get<2>(k));
   }
 
   struct cd_state {
+  #if DEVA_PDES_FUTURE_CALENDAR
+    deva::intrusive_calendar_queue<
+        stamped_event, stamped_event,
+        stamped_event::future_ix_of, deva::identity<stamped_event>,
+        stamped_event::time_of>
+      future_events;
+  #elif DEVA_PDES_FUTURE_SOA
+    deva::intrusive_soa_heap<
+        stamped_event, stamped_event::stamp,
+        stamped_event::future_ix_of, stamped_event::stamp_of>
+      future_events;
+  #else
     deva::intrusive_min_heap<
         stamped_event, stamped_event,
         stamped_event::future_ix_of, deva::identity<stamped_event>>
       future_events;
+  #endif
     
-    deva::queue<stamped_event> past_events;
+    deva::ordered_queue<stamped_event> past_events;
+    // frames of `execute_context::save()`'d data, one per state_saved event in past
+    deva::queue<uint64_t> undo_log;
     int32_t cd_ix;
-    int32_t by_now_ix, by_dawn_ix;
+    // rank which created the cd (naming it along with `cd_ix`), rank executing
+    // it, and its index in the host's `sim_me.hosted` (-1 while being leased)
+    int32_t home_rank, host_rank, host_slot;
+    int32_t far_n = 0; // entries held for it in the host's `from_far`
+    uint64_t drain_commit_n = 0; // committed by the last drain
+    int32_t by_now_ix, by_dawn_ix, by_go_ix;
+    // Per-cd optimism throttle (see `cd_throttle`): how much this cd's window
+    // is shorter than the global lookahead, adapted from its undo ratio.
+    uint64_t throttle = 0;
+    uint32_t throttle_exec_n = 0, throttle_undo_n = 0;
     int undo_n_hi=0, undo_n_lo=0;
     uint64_t seq_id_bumper, seq_id_bumper_rewind;
     fridge *fridge_head = nullptr;
@@ -100,7 +147,7 @@ namespace {
       last_commit_t, rewind_commit_t;
     
     uint64_t now() const {
-      return future_events.least_key_or({nullptr, end_of_time, end_of_time}).time;
+      return future_events.size() == 0 ? end_of_time : future_events.least_key().time;
     }
     uint64_t now_after_future_insert() const {
       return future_events.least_key().time;
@@ -113,8 +160,17 @@ namespace {
     }
 
     uint64_t next_seq_id(int n);
+
+    uint64_t go_key(uint64_t now) const {
+      return now + throttle < now ? end_of_time : now + throttle;
+    }
   };
 
+  // When set (env var `deva_cd_throttle`) each cd's lookahead window shrinks or
+  // grows with its own rollback ratio, and drain() prefers cds by `go_key`.
+  const bool cd_throttle = deva::os_env<bool>("deva_cd_throttle", false);
+  constexpr uint32_t cd_throttle_period = 32; // executions between adaptations
+
   template<int32_t cd_state::*ix>
   struct cd_by {
     cd_state *cd;
@@ -122,45 +178,147 @@ namespace {
     static int32_t& ix_of(cd_by by) { return by.cd->*ix; }
     static uint64_t key_of(cd_by by) { return by.key; }
   };
+
+  // Every local rank's cds and the ranks hosting them, shared process wide so
+  // cds can migrate to any rank of the process (see `pdes::migrate`). Hosts
+  // change between drains, or within them with `cd_steal`.
+  cd_state *proc_cds[deva::worker_n];
+  std::atomic<int32_t> *proc_hosts[deva::worker_n];
+  // staging for `migrate()` and `rebalance()`, each rank writes its own entry
+  std::vector<pdes::migration> proc_moves[deva::worker_n];
+  std::vector<pair<double,cd_state*>> proc_loads[deva::worker_n];
+  // each rank's lvt as of its last drain iteration, for `cd_steal`
+  std::atomic<uint64_t> proc_lvt[deva::worker_n];
+
+  inline cd_state* cd_at(int32_t home_rank, int32_t cd_ix) {
+    return &proc_cds[home_rank - deva::process_rank_lo()][cd_ix];
+  }
+  inline int32_t host_of(int32_t home_rank, int32_t cd_ix) {
+    return proc_hosts[home_rank - deva::process_rank_lo()][cd_ix].load(std::memory_order_acquire);
+  }
+  // Whether `cd` executes here, otherwise `host` gets where its arrivals are
+  // to be passed along. A cd still being leased to us sends them back around.
+  inline bool hosted_here(cd_state *cd, int32_t &host) {
+    host = host_of(cd->home_rank, cd->cd_ix);
+    return host == deva::rank_me() && cd->host_slot >= 0;
+  }
+  
+  // an event committed below gvt whose commit() is yet to run
+  struct commit_record {
+    event *e;
+    event_context cxt;
+    bool should_delete;
+  };
+  
+  // The rank wide heaps keyed by time, d-ary with brutal `pheap=4|8`.
+  template<typename T, typename Key, int&(&ix_of)(T), Key(&key_of)(T)>
+  using rank_heap =
+  #if DEVA_PDES_HEAP_ARITY > 2
+    deva::intrusive_dary_heap<T, Key, ix_of, key_of, DEVA_PDES_HEAP_ARITY>;
+  #else
+    deva::intrusive_min_heap<T, Key, ix_of, key_of>;
+  #endif
   
   struct sim_state {
     int32_t local_cd_n = -1;
     unique_ptr<cd_state[]> cds;
+    unique_ptr<std::atomic<int32_t>[]> hosts; // host rank of each of `cds`
+    std::vector<cd_state*> hosted; // cds executing here, by `host_slot`
     
-    deva::intrusive_min_heap<
+    rank_heap<
         cd_by<&cd_state::by_now_ix>,
         uint64_t,
         cd_by<&cd_state::by_now_ix>::ix_of,
         cd_by<&cd_state::by_now_ix>::key_of>
       cds_by_now;
     
-    deva::intrusive_min_heap<
+    rank_heap<
         cd_by<&cd_state::by_dawn_ix>,
         uint64_t,
         cd_by<&cd_state::by_dawn_ix>::ix_of,
         cd_by<&cd_state::by_dawn_ix>::key_of>
       cds_by_dawn;
 
+    // only maintained with `cd_throttle`
+    rank_heap<
+        cd_by<&cd_state::by_go_ix>,
+        uint64_t,
+        cd_by<&cd_state::by_go_ix>::ix_of,
+        cd_by<&cd_state::by_go_ix>::key_of>
+      cds_by_go;
+    uint64_t look_window = 0; // look_t_ub - gvt as of last calculation
+    double throttle_undo_avg = 0; // running mean of per-cd undo ratios
+
+    void now_decreased(cd_state *cd, uint64_t now) {
+      cds_by_now.decreased({cd, now});
+      if(cd_throttle)
+        cds_by_go.decreased({cd, cd->go_key(now)});
+    }
+    void now_increased(cd_state *cd, uint64_t now) {
+      cds_by_now.increased({cd, now});
+      if(cd_throttle)
+        cds_by_go.increased({cd, cd->go_key(now)});
+    }
+    void now_changed(cd_state *cd, uint64_t now) {
+      cds_by_now.changed({cd, now});
+      if(cd_throttle)
+        cds_by_go.changed({cd, cd->go_key(now)});
+    }
+
     deva::intrusive_map<
-        event_on_creator, pair<uint64_t,uint64_t>,
+        event_on_creator, far_key,
         event_on_creator::far_next_of,
         far_id_time_of, far_id_time_hash>
       from_far;
 
     // time-sorted list of all locally created events which were sent away
-    deva::intrusive_min_heap<
+    rank_heap<
         event*, uint64_t,
         event::sent_near_ix_of, event::time_of>
       sent_near;
 
-    event *anni_near_cold_head = nullptr;
+    // annihilated near-sent events, deleted once their anti-messages are known
+    // received: hot holds those sent in the current gvt epoch, aged holds
+    // older hot lists by epoch
     event *anni_near_hot_head = nullptr;
-
+    std::deque<pair<uint64_t, event*>> anni_near_aged;
+
+    // anti-messages gathered by a rollback (or lazy cancellation) and sent as
+    // one message per target rank by `flush_antis()`
+    struct anti_far { int32_t rank, cd; uint64_t far_id, time; };
+    struct anti_near { int32_t rank, home, cd; stamped_event se; }; // rank is the cd's host
+    std::vector<anti_far> antis_far;
+    std::vector<anti_near> antis_near;
+
+    uint64_t drain_t_end = end_of_time;
+
+    // `at_gvt` callbacks by milestone, fired in registration order per time
+    std::multimap<uint64_t, std::function<void(uint64_t)>> milestones;
+
+    // with `commit_offload`: committed events not yet handed to the committer,
+    // how many were handed over, and how many it has finished
+    bool offload = false;
+    std::vector<commit_record> offload_recs;
+    uint64_t offload_sent = 0;
+    std::atomic<uint64_t> offload_done{0};
+    // committer's live_event_{balance|bytes} on our behalf
+    std::atomic<int64_t> offload_balance{0}, offload_bytes{0};
+    
     bool has_rewind = false;
-    std::vector<event*> rewind_roots; // roots targeted at us
+    std::vector<pair<event*,cd_state*>> rewind_roots; // roots targeted at us
     std::vector<event*> rewind_created_near; // roots we created but sent away near
 
+    // with `cd_steal`: ranks asking us for a cd, whether we've asked and await
+    // the answer, and whether we were refused since the last gvt result. Asks
+    // and refusals aren't tracked by gvt so they carry the `drain_seq` they
+    // were sent in, those arriving outside of it are dropped.
+    std::vector<int32_t> steal_asks;
+    bool steal_pending = false, steal_refused = false;
+    bool draining = false;
+    uint64_t drain_seq = 0; // drains begun by this rank, never reset
+
     statistics stats;
+    uint64_t arrived_n = 0; // events & anti-events delivered to us, gauges inbound pressure
 
     #if DRAIN_TIMER
       bool spinning_empty = false;
@@ -193,6 +351,7 @@ namespace {
           events.resize(cd_n);
         }
         void record_event (int cd, uint64_t time, int gen_rank, int gen_cd, uint64_t gen_time) {
+          if (cd >= events.size()) events.resize(cd + 1); // migrated in
           events[cd].push_back({time, gen_rank, gen_cd, gen_time});
         }
         friend std::ostream & operator<< (std::ostream & os, const Timeline & tl) {
@@ -210,14 +369,134 @@ namespace {
   };
   
   thread_local sim_state sim_me;
+
+  // One per process when `commit_offload`, runs the commit()s of batches handed
+  // over by its ranks in the order they arrive. Started by `pdes::init()` and
+  // stopped by `pdes::finalize()`.
+  struct commit_batch {
+    std::vector<commit_record> recs;
+    sim_state *owner;
+  };
+  
+  struct committer_state {
+    std::mutex lock;
+    std::condition_variable wake;
+    std::deque<commit_batch*> queue;
+    bool stopping = false;
+    std::thread thread;
+  } committer;
+
+  void committer_main() {
+    std::unique_lock<std::mutex> locked(committer.lock);
+    
+    while(true) {
+      committer.wake.wait(locked, []() {
+        return committer.stopping || !committer.queue.empty();
+      });
+      
+      if(committer.queue.empty())
+        return;
+      
+      commit_batch *b = committer.queue.front();
+      committer.queue.pop_front();
+      locked.unlock();
+
+      for(commit_record const &r: b->recs)
+        r.e->vtbl_on_target->commit(r.e, r.cxt, r.should_delete);
+
+      b->owner->offload_balance.fetch_add(live_event_balance, std::memory_order_relaxed);
+      b->owner->offload_bytes.fetch_add(live_event_bytes, std::memory_order_relaxed);
+      live_event_balance = 0;
+      live_event_bytes = 0;
+      
+      // hand freed memory back to its owners
+      deva::opnew::progress();
+      
+      b->owner->offload_done.fetch_add(b->recs.size(), std::memory_order_release);
+      delete b;
+      
+      locked.lock();
+    }
+  }
+
+  // Hands events committed so far over to the committer, returns whether it
+  // has finished with every one we've handed it.
+  bool offload_flush() {
+    if(!sim_me.offload_recs.empty()) {
+      sim_me.offload_sent += sim_me.offload_recs.size();
+      commit_batch *b = new commit_batch{std::move(sim_me.offload_recs), &sim_me};
+      sim_me.offload_recs.clear();
+      {
+        std::lock_guard<std::mutex> locked(committer.lock);
+        committer.queue.push_back(b);
+      }
+      committer.wake.notify_one();
+    }
+
+    if(sim_me.offload_done.load(std::memory_order_acquire) != sim_me.offload_sent)
+      return false;
+    
+    live_event_balance += sim_me.offload_balance.exchange(0, std::memory_order_relaxed);
+    live_event_bytes += sim_me.offload_bytes.exchange(0, std::memory_order_relaxed);
+    return true;
+  }
   
   template<int charge>
-  void arrive_near(int32_t cd_ix, stamped_event e);
+  void arrive_near(cd_state *cd, stamped_event e);
+  int arrive_far_at(cd_state *cd, uint64_t far_id, uint64_t time, event *e);
+  int arrive_far_anti_at(cd_state *cd, uint64_t far_id, uint64_t time);
   
   void insert_past(cd_state *cd, stamped_event ins);
   void remove_past(cd_state *cd, stamped_event rem);
   void rollback(cd_state *cd, int undo_n);
 
+  void send_anti_near(event *sent);
+  int32_t send_anti_far(sent_far_record *far);
+  void send_anti_lists(event *near_head, sent_far_record *far_head);
+  void cancel_lazy_sent(event *e);
+  void flush_antis();
+
+  bool close_save_frame(cd_state *cd, execute_context_impl &cxt);
+
+  // Fire the `at_gvt` callbacks of every milestone <= `t_ub`, including any
+  // registered by the callbacks themselves.
+  void fire_milestones(uint64_t t_ub) {
+    auto &ms = sim_me.milestones;
+    while(!ms.empty() && ms.begin()->first <= t_ub) {
+      uint64_t t = ms.begin()->first;
+      std::function<void(uint64_t)> fn = std::move(ms.begin()->second);
+      ms.erase(ms.begin());
+      fn(t);
+    }
+  }
+  
+  // Over the last `cd_throttle_period` executions compare the cd's undo ratio
+  // against the rank's running average: well above it grows the throttle, at
+  // or below shrinks it. The throttle never exceeds half the global window so
+  // throttling can't feed back into fully conservative execution.
+  void adapt_throttle(cd_state *cd) {
+    double ratio = double(cd->throttle_undo_n)/double(cd->throttle_exec_n);
+    double &avg = sim_me.throttle_undo_avg;
+    avg += (ratio - avg)*(1.0/64);
+    
+    uint64_t w = sim_me.look_window/2;
+    uint64_t t = cd->throttle;
+    
+    if(ratio > 2*avg + 1.0/16)
+      t = std::min(w, t == 0 ? w/8 : 2*t);
+    else if(ratio <= avg)
+      t = t/2 < w/64 ? 0 : t/2;
+
+    cd->throttle_exec_n = 0;
+    cd->throttle_undo_n = 0;
+    
+    if(t != cd->throttle) {
+      cd->throttle = t;
+      sim_me.cds_by_go.changed({cd, cd->go_key(cd->now())});
+    }
+  }
+  void restore_save_frame(cd_state *cd);
+
   inline uint64_t cd_state::next_seq_id(int n) {
     uint64_t id = seq_id_bumper;
     seq_id_bumper += n*seq_id_delta;
@@ -321,22 +600,47 @@ void pdes::init(int32_t local_cd_n) {
   seq_id_delta = global_cd_n;
   
   cd_state *cds = new cd_state[local_cd_n];
+  std::atomic<int32_t> *hosts = new std::atomic<int32_t>[local_cd_n];
 
   DEVA_ASSERT_ALWAYS(!sim_me.cds);
   sim_me.cds.reset(cds);
+  sim_me.hosts.reset(hosts);
+  sim_me.hosted.resize(local_cd_n);
+  proc_cds[deva::rank_me() - deva::process_rank_lo()] = cds;
+  proc_hosts[deva::rank_me() - deva::process_rank_lo()] = hosts;
   sim_me.cds_by_dawn.resize(local_cd_n);
   sim_me.cds_by_now.resize(local_cd_n);
+  if(cd_throttle)
+    sim_me.cds_by_go.resize(local_cd_n);
   
   for(int32_t i=0; i < local_cd_n; i++) {
     cds[i].cd_ix = i;
+    cds[i].home_rank = deva::rank_me();
+    cds[i].host_rank = deva::rank_me();
+    cds[i].host_slot = i;
+    hosts[i] = deva::rank_me();
+    sim_me.hosted[i] = &cds[i];
     cds[i].seq_id_bumper = global_cd_begin + i;
     cds[i].last_commit_t = {0,0};
     sim_me.cds_by_dawn.insert({&cds[i], cds[i].dawn()});
     sim_me.cds_by_now.insert({&cds[i], cds[i].now()});
+    if(cd_throttle)
+      sim_me.cds_by_go.insert({&cds[i], cds[i].go_key(cds[i].now())});
   }
   
   sim_me.stats = {};
 
+  DEVA_ASSERT_ALWAYS(!cd_steal || !DEVA_GVT_MATTERN,
+    "pdes::cd_steal needs pgvt=epoch, whose forwards keep their epoch tag.");
+
+  sim_me.offload = commit_offload;
+  sim_me.offload_sent = 0;
+  sim_me.offload_done.store(0, std::memory_order_relaxed);
+  if(commit_offload && deva::rank_me_local() == 0) {
+    committer.stopping = false;
+    committer.thread = std::thread(committer_main);
+  }
+
   #if TIMELINE
     sim_me.timeline.init(local_cd_n);
   #endif
@@ -366,6 +670,10 @@ void detail::register_state(int cd_ix, fridge *fr) {
   cd->fridge_head = fr;
 }
 
+void pdes::at_gvt(uint64_t t, std::function<void(uint64_t)> fn) {
+  sim_me.milestones.emplace(t, std::move(fn));
+}
+
 void pdes::register_checksum_if_debug(int32_t cd_ix, std::function<uint64_t()> &&fn) {
 #if DEBUG
   cd_state *cd = &sim_me.cds[cd_ix];
@@ -377,94 +685,157 @@ void detail::root_event(int32_t cd_ix, event *e) {
   DEVA_ASSERT(0 <= cd_ix && cd_ix < sim_me.local_cd_n);
 
   cd_state *cd = &sim_me.cds[cd_ix];
+  DEVA_ASSERT_ALWAYS(cd->host_rank == deva::rank_me(), "Root events must be inserted by the rank hosting the cd, this one migrated to "<<cd->host_rank<<".");
   e->created_here = true;
   e->rewind_root = false;
   e->existence = 1;
   e->future_not_past = true;
   
   cd->future_events.insert({e, e->time, e->subtime});
-  sim_me.cds_by_now.decreased({cd, cd->now_after_future_insert()});
+  sim_me.now_decreased(cd, cd->now_after_future_insert());
 }
 
-std::uint64_t detail::next_seq_id(std::int32_t cd, int n) {
-  return sim_me.cds[cd].next_seq_id(n);
+std::uint64_t detail::next_seq_id(execute_context_impl *cxt, int n) {
+  return cd_at(cxt->cd_home, cxt->cd)->next_seq_id(n);
 }
 
-bool detail::arrive_far(uint64_t far_id, uint64_t time, int32_t cd, event *e) {
-  e->far_id = far_id;
-  e->time = time;
-  e->target_cd = cd;
-
-  bool annihilated = false;
+int detail::arrive_far(uint64_t far_id, uint64_t time, int32_t cd_ix, event *e) {
+  int32_t host = sim_me.hosts[cd_ix];
   
-  sim_me.from_far.visit({far_id, time},
-    [&](event_on_creator *o)->event_on_creator* {
-      if(o == nullptr) {
-        //deva::say()<<"far insert origin="<<origin<<" id="<<far_id<<" o="<<(event_on_creator*)e;
-        // insert event
-        e->created_here = true;
-        e->rewind_root = false;
-        arrive_near<+1>(e->target_cd, stamped_event{e, e->time, e->subtime});
-        annihilated = false;
-        return e;
-      }
-      else {
-        //deva::say()<<"far anni-+ origin="<<origin<<" id="<<far_id<<" o="<<(void*)o;
-        DEVA_ASSERT(o->vtbl_on_creator == &anti_vtable);
-        delete o;
-        e->vtbl_on_creator->destruct_and_delete(e);
-        annihilated = true;
-        return nullptr;
-      }
-    }
-  );
+  if(host != deva::rank_me()) {
+    // cd migrated, pass along to its host
+    int32_t home = deva::rank_me();
+    gvt::forward(host, /*local=*/deva::ctrue3, time,
+      [=]() { arrive_far_at(cd_at(home, cd_ix), far_id, time, e); }
+    );
+    return -1;
+  }
+  
+  return arrive_far_at(&sim_me.cds[cd_ix], far_id, time, e);
+}
 
-  return annihilated;
+int detail::arrive_far_anti(uint64_t far_id, uint64_t time, int32_t cd_ix) {
+  int32_t host = sim_me.hosts[cd_ix];
+  
+  if(host != deva::rank_me()) {
+    int32_t home = deva::rank_me();
+    gvt::forward(host, /*local=*/deva::ctrue3, time,
+      [=]() { arrive_far_anti_at(cd_at(home, cd_ix), far_id, time); }
+    );
+    return -1;
+  }
+  
+  return arrive_far_anti_at(&sim_me.cds[cd_ix], far_id, time);
 }
 
-bool detail::arrive_far_anti(uint64_t far_id, uint64_t time) {
-  bool annihilated = false;
+namespace {
+  int arrive_far_at(cd_state *cd, uint64_t far_id, uint64_t time, event *e) {
+    int32_t host;
+    if(cd_steal && !hosted_here(cd, host)) {
+      gvt::forward(host, /*local=*/deva::ctrue3, time,
+        [=]() { arrive_far_at(cd, far_id, time, e); }
+      );
+      return -1;
+    }
+    
+    sim_me.arrived_n += 1;
+    e->far_id = far_id;
+    e->far_home = cd->home_rank;
+    e->time = time;
+    e->target_cd = cd->cd_ix;
+
+    bool annihilated = false;
   
-  sim_me.from_far.visit({far_id, time},
-    [&](event_on_creator *o)->event_on_creator* {
-      if(o != nullptr) {
-        //deva::say()<<"far anni+- id="<<far_id<<" o="<<o;
-        DEVA_ASSERT(o->vtbl_on_creator != &anti_vtable);
-        // late anninilation
-        auto *e = static_cast<event*>(o);
-        stamped_event se{e, e->time, e->subtime};
-        cd_state *cd = &sim_me.cds[e->target_cd];
-        if(e->future_not_past) {
-          cd->future_events.erase(se);
-          sim_me.cds_by_now.increased({cd, cd->now()});
+    sim_me.from_far.visit(far_key{far_id, time, cd->home_rank},
+      [&](event_on_creator *o)->event_on_creator* {
+        if(o == nullptr) {
+          //deva::say()<<"far insert origin="<<origin<<" id="<<far_id<<" o="<<(event_on_creator*)e;
+          // insert event
+          e->created_here = true;
+          e->rewind_root = false;
+          arrive_near<+1>(cd, stamped_event{e, e->time, e->subtime});
+          cd->far_n += 1;
+          annihilated = false;
+          return e;
+        }
+        else {
+          //deva::say()<<"far anni-+ origin="<<origin<<" id="<<far_id<<" o="<<(void*)o;
+          DEVA_ASSERT(o->vtbl_on_creator == &anti_vtable);
+          delete o;
           e->vtbl_on_creator->destruct_and_delete(e);
+          cd->far_n -= 1;
+          annihilated = true;
+          return nullptr;
         }
-        else
-          remove_past(cd, se);
-        annihilated = true;
-        return nullptr;
-      }
-      else {
-        // insert anti-event
-        o = new event_on_creator;
-        o->vtbl_on_creator = &anti_vtable;
-        o->far_id = far_id;
-        o->time = time;
-        annihilated = false;
-        return o;
       }
+    );
+
+    return annihilated;
+  }
+
+  int arrive_far_anti_at(cd_state *cd, uint64_t far_id, uint64_t time) {
+    int32_t host;
+    if(cd_steal && !hosted_here(cd, host)) {
+      gvt::forward(host, /*local=*/deva::ctrue3, time,
+        [=]() { arrive_far_anti_at(cd, far_id, time); }
+      );
+      return -1;
     }
-  );
+    
+    sim_me.arrived_n += 1;
+    bool annihilated = false;
+  
+    sim_me.from_far.visit(far_key{far_id, time, cd->home_rank},
+      [&](event_on_creator *o)->event_on_creator* {
+        if(o != nullptr) {
+          //deva::say()<<"far anni+- id="<<far_id<<" o="<<o;
+          DEVA_ASSERT(o->vtbl_on_creator != &anti_vtable);
+          // late anninilation
+          auto *e = static_cast<event*>(o);
+          stamped_event se{e, e->time, e->subtime};
+          if(e->future_not_past) {
+            cd->future_events.erase(se);
+            sim_me.now_increased(cd, cd->now());
+            cancel_lazy_sent(e);
+            flush_antis();
+            e->vtbl_on_creator->destruct_and_delete(e);
+          }
+          else
+            remove_past(cd, se);
+          cd->far_n -= 1;
+          annihilated = true;
+          return nullptr;
+        }
+        else {
+          // insert anti-event
+          o = new event_on_creator;
+          o->vtbl_on_creator = &anti_vtable;
+          o->far_id = far_id;
+          o->far_home = cd->home_rank;
+          o->time = time;
+          cd->far_n += 1;
+          annihilated = false;
+          return o;
+        }
+      }
+    );
 
-  return annihilated;
-}
+    return annihilated;
+  }
 
-namespace {
   template<int charge>
-  void arrive_near(int32_t cd_ix, stamped_event se) {
+  void arrive_near(cd_state *cd, stamped_event se) {
     sim_state &sim_me = ::sim_me;
-    cd_state *cd = &sim_me.cds[cd_ix];
+    int32_t host;
+    if(cd_steal && !hosted_here(cd, host)) {
+      gvt::forward(host, /*local=*/deva::ctrue3, se.time,
+        [=]() { arrive_near<charge>(cd, se); }
+      );
+      return;
+    }
+    DEVA_ASSERT(cd->host_rank == deva::rank_me());
     
+    sim_me.arrived_n += 1;
     se.e->existence += charge;
     
     switch(charge) {
@@ -473,7 +844,7 @@ namespace {
       if(se.e->existence == 1) {
         se.e->future_not_past = true;
         cd->future_events.insert(se);
-        sim_me.cds_by_now.decreased({cd, cd->now_after_future_insert()});
+        sim_me.now_decreased(cd, cd->now_after_future_insert());
       }
       break;
       
@@ -482,7 +853,9 @@ namespace {
       if(se.e->existence == 0) {
         if(se.e->future_not_past) {
           cd->future_events.erase(se);
-          sim_me.cds_by_now.increased({cd, cd->now()});
+          sim_me.now_increased(cd, cd->now());
+          cancel_lazy_sent(se.e);
+          flush_antis();
         }
         else
           remove_past(cd, se);
@@ -490,23 +863,248 @@ namespace {
       break;
     }
   }
+
+  void send_anti_near(event *sent) {
+    stamped_event sent_se{sent, sent->time, sent->subtime};
+    
+    // remove from sent_near
+    sim_me.sent_near.erase(sent);
+    
+    // add to anni_near
+    sent->anni_near_next = sim_me.anni_near_hot_head;
+    sim_me.anni_near_hot_head = sent;
+    
+    // queue anti-message
+    sim_me.antis_near.push_back({
+      host_of(sent->target_rank, sent->target_cd),
+      sent->target_rank, sent->target_cd, sent_se
+    });
+  }
+
+  int32_t send_anti_far(sent_far_record *far) {
+    if(far->vtbl == &sent_far_one::the_vtbl) {
+      auto *one = static_cast<sent_far_one*>(far);
+      sim_me.antis_far.push_back({one->rank, one->cd, one->far_id, one->time});
+      sent_far_one::the_delete1(one);
+      return 1;
+    }
+    else
+      return far->vtbl->send_anti_and_delete(far);
+  }
+
+  void flush_antis() {
+    sim_state &sim_me = ::sim_me;
+    
+    if(!sim_me.antis_far.empty()) {
+      auto &antis = sim_me.antis_far;
+      std::stable_sort(antis.begin(), antis.end(),
+        [](sim_state::anti_far const &a, sim_state::anti_far const &b) {
+          return a.rank < b.rank;
+        }
+      );
+
+      for(size_t i=0, j; i < antis.size(); i = j) {
+        int32_t rank = antis[i].rank;
+        uint64_t t_lb = antis[i].time;
+        for(j = i+1; j < antis.size() && antis[j].rank == rank; j++)
+          t_lb = std::min(t_lb, antis[j].time);
+        
+        if(j-i == 1) {
+          int32_t cd = antis[i].cd;
+          uint64_t far_id = antis[i].far_id;
+          uint64_t time = antis[i].time;
+          gvt::send(rank, /*local=*/deva::cfalse3, time,
+            [=]() { arrive_far_anti(far_id, time, cd); }
+          );
+        }
+        else {
+          // one gvt message (and credit) for the whole group
+          std::vector<std::tuple<uint64_t,uint64_t,int32_t>> ids(j-i);
+          for(size_t k=i; k < j; k++)
+            ids[k-i] = std::make_tuple(antis[k].far_id, antis[k].time, antis[k].cd);
+          
+          gvt::send(rank, /*local=*/deva::cfalse3, t_lb,
+            [](std::vector<std::tuple<uint64_t,uint64_t,int32_t>> &&ids) {
+              for(auto const &id: ids)
+                arrive_far_anti(std::get<0>(id), std::get<1>(id), std::get<2>(id));
+            },
+            std::move(ids)
+          );
+        }
+      }
+      antis.clear();
+    }
+
+    if(!sim_me.antis_near.empty()) {
+      auto &antis = sim_me.antis_near;
+      std::stable_sort(antis.begin(), antis.end(),
+        [](sim_state::anti_near const &a, sim_state::anti_near const &b) {
+          return a.rank < b.rank;
+        }
+      );
+
+      for(size_t i=0, j; i < antis.size(); i = j) {
+        int32_t rank = antis[i].rank;
+        uint64_t t_lb = antis[i].se.time;
+        for(j = i+1; j < antis.size() && antis[j].rank == rank; j++)
+          t_lb = std::min(t_lb, antis[j].se.time);
+        
+        if(j-i == 1) {
+          int32_t home = antis[i].home;
+          int32_t cd = antis[i].cd;
+          stamped_event se = antis[i].se;
+          gvt::send(rank, /*local=*/deva::ctrue3, se.time,
+            [=]() { arrive_near<-1>(cd_at(home, cd), se); }
+          );
+        }
+        else {
+          std::vector<sim_state::anti_near> ses(antis.begin() + i, antis.begin() + j);
+          
+          gvt::send(rank, /*local=*/deva::ctrue3, t_lb,
+            [](std::vector<sim_state::anti_near> &&ses) {
+              for(auto const &a: ses)
+                arrive_near<-1>(cd_at(a.home, a.cd), a.se);
+            },
+            std::move(ses)
+          );
+        }
+      }
+      antis.clear();
+    }
+  }
+
+  void send_anti_lists(event *near_head, sent_far_record *far_head) {
+    while(near_head != nullptr) {
+      event *next = near_head->sent_near_next;
+      send_anti_near(near_head);
+      near_head = next;
+    }
+    while(far_head != nullptr) {
+      sent_far_record *next = far_head->next;
+      send_anti_far(far_head);
+      far_head = next;
+    }
+  }
+
+  // Issue the anti-messages held back by lazy cancellation for an event which
+  // is being annihilated instead of re-executed.
+  void cancel_lazy_sent(event *e) {
+    if(e->lazy_sent) {
+      e->lazy_sent = false;
+      send_anti_lists(e->sent_near_head, e->sent_far_head);
+      e->sent_near_head = nullptr;
+      e->sent_far_head = nullptr;
+    }
+  }
+}
+
+void detail::save_bytes(execute_context_impl *cxt, void *p, size_t n) {
+  deva::queue<uint64_t> &log = cd_at(cxt->cd_home, cxt->cd)->undo_log;
+  
+  if(cxt->save_frame_ix == -1) {
+    cxt->save_frame_ix = log.size();
+    log.push_back(0); // frame length, patched by close_save_frame()
+  }
+
+  // entry: data words, address, byte count
+  unsigned char const *bytes = static_cast<unsigned char const*>(p);
+  for(size_t i=0; i < n; i += 8) {
+    uint64_t w = 0;
+    std::memcpy(&w, bytes + i, std::min<size_t>(8, n-i));
+    log.push_back(w);
+  }
+  log.push_back(reinterpret_cast<uintptr_t>(p));
+  log.push_back(n);
 }
 
 namespace {
-  void insert_past(cd_state *cd, stamped_event ins) {
-    int n = cd->past_events.size();
-    cd->past_events.push_back({});
+  bool close_save_frame(cd_state *cd, execute_context_impl &cxt) {
+    if(cxt.save_frame_ix == -1)
+      return false;
+    
+    uint64_t len = cd->undo_log.size() + 1 - cxt.save_frame_ix;
+    cd->undo_log.at_forwards(cxt.save_frame_ix) = len;
+    cd->undo_log.push_back(len);
+    return true;
+  }
 
-    int j = 0;
-    while(j < n) {
-      stamped_event se = cd->past_events.at_backwards(j+1);
-      if(se <= ins)
-        break;
-      cd->past_events.at_backwards(j) = se;
-      j += 1;
+  // Restores the last frame's entries newest first, so the oldest value of a
+  // location saved multiple times wins.
+  void restore_save_frame(cd_state *cd) {
+    deva::queue<uint64_t> &log = cd->undo_log;
+    int len = int(log.at_backwards(0));
+    int beg = log.size() - len;
+    int i = log.size() - 2;
+
+    while(i > beg) {
+      size_t n = log.at_forwards(i);
+      auto *p = reinterpret_cast<unsigned char*>(log.at_forwards(i-1));
+      int wn = int((n + 7)/8);
+      int d = i-1 - wn;
+      
+      for(int k=0; k < wn; k++) {
+        uint64_t w = log.at_forwards(d + k);
+        std::memcpy(p + 8*k, &w, std::min<size_t>(8, n - 8*k));
+      }
+      i = d-1;
     }
     
-    cd->past_events.at_backwards(j) = ins;
+    log.chop_back(len);
+  }
+}
+
+bool detail::lazy_reclaim_near(
+    execute_context_impl *cxt, int32_t rank, int32_t cd,
+    uint64_t time, uint64_t subtime,
+    event_vtable const *vtbl, uint64_t payload_hash,
+    bool(*same_user)(event const*, void const*), void const *user
+  ) {
+  event **pp = &cxt->lazy_near_head;
+  while(*pp != nullptr) {
+    event *e = *pp;
+    if(e->payload_hash == payload_hash && e->time == time &&
+       e->subtime == subtime && e->target_cd == cd &&
+       e->target_rank == rank && e->vtbl_on_creator == vtbl &&
+       same_user(e, user)) {
+      *pp = e->sent_near_next;
+      e->sent_near_next = cxt->lazy_kept_near_head;
+      cxt->lazy_kept_near_head = e;
+      sim_me.stats.cancel_avoided_n += 1;
+      return true;
+    }
+    pp = &e->sent_near_next;
+  }
+  return false;
+}
+
+bool detail::lazy_reclaim_far(
+    execute_context_impl *cxt, int32_t rank, int32_t cd,
+    uint64_t time, uint64_t subtime,
+    event_vtable const *vtbl, uint64_t payload_hash,
+    void const *user, size_t size
+  ) {
+  sent_far_record **pp = &cxt->lazy_far_head;
+  while(*pp != nullptr) {
+    // only `sent_far_one`'s are held back
+    auto *far = static_cast<sent_far_one*>(*pp);
+    if(far->payload_hash == payload_hash && far->time == time &&
+       far->subtime == subtime && far->cd == cd &&
+       far->rank == rank && far->vtbl_event == vtbl &&
+       0 == std::memcmp(far->payload, user, size)) {
+      *pp = far->next;
+      far->next = cxt->sent_far_head;
+      cxt->sent_far_head = far;
+      sim_me.stats.cancel_avoided_n += 1;
+      return true;
+    }
+    pp = &far->next;
+  }
+  return false;
+}
+
+namespace {
+  void insert_past(cd_state *cd, stamped_event ins) {
+    int j = cd->past_events.insert(ins);
 
     sim_me.cds_by_dawn.decreased({cd, cd->dawn_after_past_insert()});
     
@@ -515,9 +1113,9 @@ namespace {
   }
 
   void remove_past(cd_state *cd, stamped_event rem) {
-    int j = 0;
-    while(rem.e != cd->past_events.at_backwards(j).e)
-      j += 1;
+    int j = cd->past_events.find_backwards(rem,
+      [&](stamped_event se) { return se.e == rem.e; }
+    );
     
     rem.e->remove_after_undo = true;
     
@@ -526,7 +1124,6 @@ namespace {
 
   void rollback(cd_state *cd, int undo_n) {
     sim_state &sim_me = ::sim_me;
-    const int rank_me = deva::rank_me();
 
     #if DRAIN_TIMER
       sim_me.drain_timer.update(DrainTimer::Cat::rollback);
@@ -550,6 +1147,11 @@ namespace {
         stamped_event se = cd->past_events.at_backwards(i++);
         event *e = se.e;
         
+        // With lazy cancellation the off-rank sends are kept on the event
+        // until we know in the unexecute pass whether it will be re-executed.
+        event *lazy_near_head = nullptr;
+        sent_far_record *lazy_far_head = nullptr;
+        
         { // walk far-sent events
           sent_far_record *far = e->sent_far_head;
           e->sent_far_head = nullptr;
@@ -558,11 +1160,15 @@ namespace {
             sent_far_record *far_next = far->next;
             int unseq;
             
-            if(far->vtbl == &sent_far_one::the_vtbl)
-              unseq = sent_far_one::the_send_anti_and_delete(far);
+            if(lazy_cancel && far->vtbl == &sent_far_one::the_vtbl) {
+              far->next = lazy_far_head;
+              lazy_far_head = far;
+              unseq = 1;
+            }
             else
-              unseq = far->vtbl->send_anti_and_delete(far);
+              unseq = send_anti_far(far);
             
+            sim_me.stats.cancel_n += unseq;
             cd->next_seq_id(-unseq);
             far = far_next;
           }
@@ -576,28 +1182,26 @@ namespace {
           event *sent_next = sent->sent_near_next;
           stamped_event sent_se{sent, sent->time, sent->subtime};
           
-          if(sent->target_rank != rank_me) { // event sent to near-remote
-            // remove from sent_near
-            sim_me.sent_near.erase(sent);
+          // as decided when sent, a cd leased away since had its arrivals
+          // from us turned near-remote
+          if(!sent->created_here) { // event sent to near-remote
+            sim_me.stats.cancel_n += 1;
             
-            // add to anni_near
-            sent->anni_near_next = sim_me.anni_near_hot_head;
-            sim_me.anni_near_hot_head = sent;
-            
-            // send anti-message
-            int32_t target_cd = sent->target_cd;
-            gvt::send(
-              sent->target_rank, /*local=*/deva::ctrue3, sent->time,
-              [=]() { arrive_near<-1>(target_cd, sent_se); }
-            );
+            if(lazy_cancel) {
+              sent->sent_near_next = lazy_near_head;
+              lazy_near_head = sent;
+            }
+            else
+              send_anti_near(sent);
           }
           else { // sent event to myself
-            cd_state *cd1 = &sim_me.cds[sent->target_cd];
+            cd_state *cd1 = cd_at(sent->target_rank, sent->target_cd);
 
             if(sent->future_not_past) {
               // can remove now, hasn't executed
               cd1->future_events.erase(sent_se);
-              sim_me.cds_by_now.increased({cd1, cd1->now()});
+              sim_me.now_increased(cd1, cd1->now());
+              cancel_lazy_sent(sent);
               // add to deferred delete list
               sent->sent_near_next = del_head;
               del_head = sent;
@@ -612,9 +1216,10 @@ namespace {
                 bool already_all = cd1->undo_n_hi != 0;
                 DEVA_ASSERT(!already_fresh || already_all);
                 
-                int j = cd1->undo_n_hi;
-                while(sent != cd1->past_events.at_backwards(j).e)
-                  j += 1;
+                int j = cd1->past_events.find_backwards(sent_se,
+                  [&](stamped_event se) { return se.e == sent; }
+                );
+                DEVA_ASSERT(j >= cd1->undo_n_hi);
                 cd1->undo_n_hi = j + 1;
 
                 if(!already_fresh) {
@@ -628,6 +1233,9 @@ namespace {
           
           sent = sent_next;
         }
+
+        e->sent_near_head = lazy_near_head;
+        e->sent_far_head = lazy_far_head;
       }
 
       cd->undo_n_lo = i;
@@ -643,20 +1251,36 @@ namespace {
     for(cd_state *cd: undos_all) {
       int n = cd->undo_n_hi;
       bool inserted_future = false;
+      cd->throttle_undo_n += n;
       
       for(int i=0; i < n; i++) {
         stamped_event se = cd->past_events.at_backwards(i);
         bool do_remove = se.e->remove_after_undo;
         bool do_delete = do_remove && se.e->created_here;
+
+        // Events beyond `t_end` won't re-execute within this drain, so their
+        // sends are cancelled now to leave no lazy state across drains.
+        if(!do_remove && se.time < sim_me.drain_t_end)
+          se.e->lazy_sent = se.e->sent_near_head != nullptr || se.e->sent_far_head != nullptr;
+        else {
+          send_anti_lists(se.e->sent_near_head, se.e->sent_far_head);
+          se.e->sent_near_head = nullptr;
+          se.e->sent_far_head = nullptr;
+        }
         
         if(!do_remove) {
           se.e->future_not_past = true;
           cd->future_events.insert(se);
           inserted_future = true;
           // handled outside loop:
-          // sim_me.cds_by_now.decreased({cd, cd->now_after_future_insert()});
+          // sim_me.now_decreased(cd, cd->now_after_future_insert());
         }
 
+        if(se.e->state_saved) {
+          se.e->state_saved = false;
+          restore_save_frame(cd);
+        }
+        
         event_context cxt;
         cxt.cd = cd->cd_ix;
         cxt.time = se.time;
@@ -664,7 +1288,7 @@ namespace {
         se.e->vtbl_on_target->unexecute(se.e, cxt, DEVA_DEBUG_ONLY(cd->checksummer,) do_delete);
 
         #if DRAIN_TIMER
-          sim_me.drain_timer.rollback_event(cd->cd_ix);
+          sim_me.drain_timer.rollback_event(cd->host_slot);
         #endif // DRAIN_TIMER
       }
 
@@ -673,7 +1297,7 @@ namespace {
       cd->past_events.chop_back(n);
       
       if(inserted_future)
-        sim_me.cds_by_now.decreased({cd, cd->now_after_future_insert()});
+        sim_me.now_decreased(cd, cd->now_after_future_insert());
 
       if(cd->past_events.size() == 0)
         sim_me.cds_by_dawn.increased({cd, end_of_time});
@@ -686,18 +1310,109 @@ namespace {
       del_head = next;
     }
 
+    flush_antis();
+
     #if DRAIN_TIMER
       sim_me.drain_timer_update_spin_or(DrainTimer::Cat::progress);
     #endif // DRAIN_TIMER
   }
 }
 
+namespace {
+  void lease_adopt(cd_state *cd) {
+    sim_state &sim_me = ::sim_me;
+    DEVA_ASSERT(cd->host_rank == deva::rank_me() && cd->host_slot == -1);
+    
+    cd->host_slot = sim_me.hosted.size();
+    sim_me.hosted.push_back(cd);
+    #if DRAIN_TIMER
+      sim_me.drain_timer.push_slot();
+    #endif // DRAIN_TIMER
+    
+    sim_me.cds_by_now.insert({cd, cd->now()});
+    sim_me.cds_by_dawn.insert({cd, cd->dawn()});
+    if(cd_throttle)
+      sim_me.cds_by_go.insert({cd, cd->go_key(cd->now())});
+    
+    sim_me.stats.steal_n += 1;
+    sim_me.steal_pending = false;
+  }
+
+  // The cd to lease a sibling (see `cd_steal`) if we have one to spare. No
+  // rollback may reach into it so it must have nothing executed but
+  // uncommitted, and nothing held in `from_far`. Of those the one with the
+  // least event under `exec_t_ub`, provided another cd keeps us busy.
+  cd_state* pick_lease(uint64_t exec_t_ub) {
+    if(sim_me.has_rewind || sim_me.hosted.size() < 2)
+      return nullptr;
+    
+    cd_state *best = nullptr;
+    int ready_n = 0;
+    for(cd_state *cd: sim_me.hosted) {
+      uint64_t now = cd->now();
+      if(now < exec_t_ub) {
+        ready_n += 1;
+        if(cd->past_events.size() == 0 && cd->far_n == 0 &&
+           (best == nullptr || now < best->now()))
+          best = cd;
+      }
+    }
+    return ready_n >= 2 ? best : nullptr;
+  }
+
+  // Hands `cd` over to `thief` within a drain. Our local sends still pending
+  // in its future become near-remote as though it had been hosted away all
+  // along, so we keep them in `sent_near` and its host doesn't own them.
+  // Sends held back by lazy cancellation are cancelled since re-execution
+  // happens elsewhere. The handoff is a gvt message at the cd's `now()`, so
+  // gvt can't pass its events while in flight.
+  void lease_away(cd_state *cd, int32_t thief) {
+    sim_state &sim_me = ::sim_me;
+
+    // our commit()s reach the committer before any of the thief's
+    if(sim_me.offload)
+      offload_flush();
+    
+    int n = cd->future_events.size();
+    for(int i=0; i < n; i++) {
+      event *e = cd->future_events.at(i).e;
+      cancel_lazy_sent(e);
+      if(e->created_here) {
+        e->created_here = false;
+        sim_me.sent_near.insert(e);
+      }
+    }
+    flush_antis();
+    
+    sim_me.cds_by_now.erase({cd, 0});
+    sim_me.cds_by_dawn.erase({cd, 0});
+    if(cd_throttle)
+      sim_me.cds_by_go.erase({cd, 0});
+
+    cd_state *last = sim_me.hosted.back();
+    #if DRAIN_TIMER
+      sim_me.drain_timer.move_slot(last->host_slot, cd->host_slot);
+    #endif // DRAIN_TIMER
+    sim_me.hosted[cd->host_slot] = last;
+    last->host_slot = cd->host_slot;
+    sim_me.hosted.pop_back();
+
+    cd->host_slot = -1;
+    cd->host_rank = thief;
+    proc_hosts[cd->home_rank - deva::process_rank_lo()][cd->cd_ix].store(thief, std::memory_order_release);
+    
+    gvt::send(thief, /*local=*/deva::ctrue3, cd->now(),
+      [=]() { lease_adopt(cd); }
+    );
+  }
+}
+
 uint64_t pdes::drain(uint64_t t_end, bool rewindable) {
   sim_state &sim_me = ::sim_me;
   const int32_t rank_me = deva::rank_me();
 
   #if DRAIN_TIMER
-    sim_me.drain_timer.init(sim_me.local_cd_n);
+    sim_me.drain_timer.init(sim_me.hosted.size());
   #endif // DRAIN_TIMER
 
   //////////////////////////////////////////////////////////////////////////////
@@ -707,11 +1422,13 @@ uint64_t pdes::drain(uint64_t t_end, bool rewindable) {
     "Lingering rewind state must be rewound via pdes::rewind(true|false) before calling pdes::drain()."
   );
 
+  for(cd_state *cd: sim_me.hosted)
+    cd->drain_commit_n = 0;
+
   if(rewindable) {
     sim_me.has_rewind = true;
     
-    for(int32_t cd_ix=0; cd_ix < sim_me.local_cd_n; cd_ix++) {
-      cd_state *cd = &sim_me.cds[cd_ix];
+    for(cd_state *cd: sim_me.hosted) {
       cd->seq_id_bumper_rewind = cd->seq_id_bumper;
       cd->rewind_commit_t = cd->last_commit_t;
       
@@ -721,7 +1438,7 @@ uint64_t pdes::drain(uint64_t t_end, bool rewindable) {
       for(int i=0; i < n; i++) {
         stamped_event se = cd->future_events.at(i);
         se.e->rewind_root = true; // prevents deleting rewind roots
-        sim_me.rewind_roots.push_back(se.e);
+        sim_me.rewind_roots.push_back({se.e, cd});
       }
 
       for(fridge *f=cd->fridge_head; f != nullptr; f = f->next)
@@ -738,9 +1455,17 @@ uint64_t pdes::drain(uint64_t t_end, bool rewindable) {
     }
   }
 
+  sim_me.drain_t_end = t_end;
+  sim_me.draining = true;
+  sim_me.drain_seq += 1;
+  sim_me.steal_pending = false;
+  sim_me.steal_refused = false;
+
   //////////////////////////////////////////////////////////////////////////////
 
-  uint64_t gvt_returned;
+  uint64_t gvt_returned = 0;
+  bool ending = false;
+  int ending_begin_n = 0; // collectives still to begin before returning
   
   uint64_t executed_n = 0;
   uint64_t committed_n = 0;
@@ -751,16 +1476,115 @@ uint64_t pdes::drain(uint64_t t_end, bool rewindable) {
 
   gvt::reducibles rxs_acc = {0,0};
   uint64_t look_t_ub;
+  uint64_t commit_gvt; // commits lag gvt while `commit_backlog`
+  bool commit_backlog = false;
   {
     uint64_t lvt = sim_me.cds_by_now.least_key();
+    proc_lvt[rank_me - deva::process_rank_lo()].store(lvt, std::memory_order_relaxed);
     uint64_t gvt0 = deva::reduce_min(lvt);
     
     gvt::init(gvt0, {0, 0});
     gvt::coll_begin(lvt, {0, 0});
+    commit_gvt = gvt0;
 
     look_t_ub = global_status.calc_look_t_ub(gvt0, t_end);
+    sim_me.look_window = look_t_ub - std::min(look_t_ub, gvt0);
   }
 
+  auto over_budget = []()->bool {
+    return memory_budget > 0 && live_event_bytes > memory_budget;
+  };
+
+  // Commits events that have fallen behind `commit_gvt`, stopping at each
+  // milestone in between to fire its callbacks. Gives up after `budget` events
+  // when positive, returning whether all were committed.
+  auto commit_behind = [&](int budget)->bool {
+    int left = budget > 0 ? budget : std::numeric_limits<int>::max();
+    uint64_t commit_ub;
+    do {
+      commit_ub = std::min(commit_gvt, sim_me.milestones.empty() ? commit_gvt : sim_me.milestones.begin()->first);
+
+      while(true) {
+        cd_state *cd = sim_me.cds_by_dawn.peek_least().cd;
+        int past_n = std::min<int>(cd->past_events.size(), left);
+        int commit_n = 0;
+
+        while(commit_n < past_n) {
+          stamped_event se = cd->past_events.at_forwards(commit_n);
+          if(se.time >= commit_ub)
+            break;
+
+          auto current_t = std::make_pair(se.time+1, se.subtime);
+          DEVA_ASSERT(cd->last_commit_t <= current_t);
+          sim_me.stats.deterministic &= cd->last_commit_t < current_t;
+          cd->last_commit_t = current_t;
+
+          bool should_delete = se.e->created_here && !se.e->rewind_root;
+
+          if(se.e->state_saved) {
+            se.e->state_saved = false;
+            cd->undo_log.chop_front(int(cd->undo_log.at_forwards(0)));
+          }
+
+          if(should_delete) {
+            if(se.e->far_next != reinterpret_cast<event_on_creator*>(0x1)) {
+              //deva::say()<<"committed from_far remove origin="<<se.e->far_origin<<" id="<<se.e->far_id;
+              sim_me.from_far.remove(se.e);
+              cd->far_n -= 1;
+            }
+          }
+
+          { // invoke commit()
+            #if DRAIN_TIMER
+              sim_me.drain_timer.update(DrainTimer::Cat::commit);
+            #endif // DRAIN_TIMER
+
+            event_context cxt;
+            cxt.cd = cd->cd_ix;
+            cxt.time = se.time;
+            cxt.subtime = se.subtime;
+            #if TIMELINE
+              sim_me.timeline.record_event(cxt.cd, cxt.time, se.e->gen_rank, se.e->gen_cd, se.e->gen_time);
+            #endif
+            if(sim_me.offload)
+              sim_me.offload_recs.push_back({se.e, cxt, should_delete});
+            else
+              se.e->vtbl_on_target->commit(se.e, cxt, should_delete);
+
+            #if DRAIN_TIMER
+              sim_me.drain_timer.commit_event(cd->host_slot);
+              sim_me.drain_timer_update_spin_or(DrainTimer::Cat::gvt);
+            #endif // DRAIN_TIMER
+          }
+          commit_n += 1;
+        }
+
+        if(commit_n == 0)
+          break;
+
+        committed_n += commit_n;
+        sim_me.stats.committed_n += commit_n;
+        cd->drain_commit_n += commit_n;
+        cd->past_events.chop_front(commit_n);
+        sim_me.cds_by_dawn.increased({cd, cd->dawn()});
+
+        left -= commit_n;
+        if(left == 0) {
+          if(sim_me.offload)
+            offload_flush();
+          return false;
+        }
+      }
+
+      // milestones (and our caller) wait on the committer
+      if(sim_me.offload && !offload_flush())
+        return false;
+      
+      fire_milestones(commit_ub);
+    } while(commit_ub != commit_gvt);
+    return true;
+  };
+  
   #if DRAIN_TIMER
     sim_me.spinning_empty = false;
     sim_me.spinning_look = false;
@@ -768,13 +1592,27 @@ uint64_t pdes::drain(uint64_t t_end, bool rewindable) {
     bool spinning = false;
   #endif // DRAIN_TIMER
   
+  int quantum = std::max(1, drain_quantum);
+  
   while(true) {
+    uint64_t arrived_n0 = sim_me.arrived_n;
+    
     #if DRAIN_TIMER
       sim_me.drain_timer_update_spin_or(DrainTimer::Cat::progress);
       deva::progress(sim_me.spinning());
     #else
       deva::progress(spinning);
     #endif // DRAIN_TIMER
+
+    // back off the quantum under inbound pressure, regrow it otherwise
+    if(sim_me.arrived_n != arrived_n0)
+      quantum = std::max(1, quantum/2);
+    else
+      quantum = std::min(std::max(1, drain_quantum), 2*quantum);
+
+    std::chrono::steady_clock::time_point quantum_t0;
+    if(drain_quantum_us > 0)
+      quantum_t0 = std::chrono::steady_clock::now();
     
     { // nurse gvt
       #if DRAIN_TIMER
@@ -789,9 +1627,10 @@ uint64_t pdes::drain(uint64_t t_end, bool rewindable) {
       if(gvt::coll_ended()) {
         //if(deva::rank_me()==0) deva::say()<<"gvt="<<gvt_old<<" coll";
         rxs_acc.reduce_with(gvt::coll_reducibles());
+        sim_me.steal_refused = false;
 
-        // delete near-sent events which were committed in previous collective round
-        while(sim_me.sent_near.least_key_or(uint64_t(-1)) < gvt_old) {
+        // delete near-sent events which every rank has committed
+        while(sim_me.sent_near.least_key_or(uint64_t(-1)) < gvt::epoch_gvt_agreed()) {
           event *e = sim_me.sent_near.pop_least();
           e->vtbl_on_creator->destruct_and_delete(e);
         }
@@ -799,12 +1638,11 @@ uint64_t pdes::drain(uint64_t t_end, bool rewindable) {
         if(gvt::coll_was_epoch()) {
           uint64_t gvt_new = gvt::epoch_gvt();
           
-          { // and delete annihilated events from previous epoch
-            event *e = sim_me.anni_near_cold_head;
-            // hot moved to cold list
-            sim_me.anni_near_cold_head = sim_me.anni_near_hot_head;
-            // hot list now empty
-            sim_me.anni_near_hot_head = nullptr;
+          // and delete annihilated events whose anti-messages have landed
+          while(!sim_me.anni_near_aged.empty() &&
+                sim_me.anni_near_aged.front().first <= gvt::epoch_settled()) {
+            event *e = sim_me.anni_near_aged.front().second;
+            sim_me.anni_near_aged.pop_front();
             
             while(e != nullptr) {
               event *e_next = e->anni_near_next;
@@ -814,80 +1652,59 @@ uint64_t pdes::drain(uint64_t t_end, bool rewindable) {
           }
 
           if(gvt_new != gvt_old) {
-            // commmit events that have fallen behind new gvt
-            while(true) {
-              cd_state *cd = sim_me.cds_by_dawn.peek_least().cd;
-              int past_n = cd->past_events.size();
-              int commit_n = 0;
-
-              while(commit_n < past_n) {
-                stamped_event se = cd->past_events.at_forwards(commit_n);
-                if(se.time >= gvt_new)
-                  break;
-                
-                auto current_t = std::make_pair(se.time+1, se.subtime);
-                DEVA_ASSERT(cd->last_commit_t <= current_t);
-                sim_me.stats.deterministic &= cd->last_commit_t < current_t;
-                cd->last_commit_t = current_t;
-                
-                bool should_delete = se.e->created_here && !se.e->rewind_root;
-                
-                if(should_delete) {
-                  if(se.e->far_next != reinterpret_cast<event_on_creator*>(0x1)) {
-                    //deva::say()<<"committed from_far remove origin="<<se.e->far_origin<<" id="<<se.e->far_id;
-                    sim_me.from_far.remove(se.e);
-                  }
-                }
-                
-                { // invoke commit()
-                  #if DRAIN_TIMER
-                    sim_me.drain_timer.update(DrainTimer::Cat::commit);
-                  #endif // DRAIN_TIMER
-
-                  event_context cxt;
-                  cxt.cd = cd->cd_ix;
-                  cxt.time = se.time;
-                  cxt.subtime = se.subtime;
-                  #if TIMELINE
-                    sim_me.timeline.record_event(cxt.cd, cxt.time, se.e->gen_rank, se.e->gen_cd, se.e->gen_time);
-                  #endif
-                  se.e->vtbl_on_target->commit(se.e, cxt, should_delete);
-
-                  #if DRAIN_TIMER
-                    sim_me.drain_timer.commit_event(cd->cd_ix);
-                    sim_me.drain_timer_update_spin_or(DrainTimer::Cat::gvt);
-                  #endif // DRAIN_TIMER
-                }
-                commit_n += 1;
-              }
-              
-              if(commit_n == 0)
-                break;
-              
-              committed_n += commit_n;
-              sim_me.stats.committed_n += commit_n;
-              cd->past_events.chop_front(commit_n);
-              sim_me.cds_by_dawn.increased({cd, cd->dawn()});
-            }
+            commit_gvt = gvt_new;
+            commit_backlog = true;
             
             // update global status
             global_status.update(rxs_acc.sum1, rxs_acc.sum2);
             rxs_acc = {0,0};
             look_t_ub = global_status.calc_look_t_ub(gvt_new, t_end);
+            sim_me.look_window = look_t_ub - std::min(look_t_ub, gvt_new);
           }
-          else if(t_end <= gvt_old) {
+          else if(t_end <= gvt_old && !ending) {
             //say()<<"drain done gvt="<<gvt_old;
             gvt_returned = gvt_old;
-            
-            if(gvt_old == uint64_t(-1))
-              goto drain_completed;
-            else
-              goto drain_paused;
+            ending = true;
+            ending_begin_n = gvt::coll_until_agreed();
           }
         }
+      }
+
+      sim_me.stats.live_event_hwm = std::max(sim_me.stats.live_event_hwm, live_event_balance);
+      sim_me.stats.live_bytes_hwm = std::max(sim_me.stats.live_bytes_hwm, live_event_bytes);
+      if(over_budget())
+        sim_me.stats.over_budget_n += 1;
+
+      // commit behind gvt a slice at a time (all at once when over budget), a
+      // rank must be done acting on a result before beginning the next
+      // collective
+      if(commit_backlog)
+        commit_backlog = !commit_behind(over_budget() ? 0 : commit_slice);
+
+      // when ending keep the pipeline going just until every rank is known to
+      // have acted on the final gvt
+      if(ending && ending_begin_n == 0) {
+        if(!commit_backlog && gvt::coll_in_flight() == 0) {
+          if(gvt_returned == uint64_t(-1))
+            goto drain_completed;
+          else
+            goto drain_paused;
+        }
+      }
+      else if(!commit_backlog && gvt::coll_can_begin()) {
+        if(ending)
+          ending_begin_n -= 1;
+
+        // anti-messages sent so far are tagged with the epoch about to close
+        if(sim_me.anni_near_hot_head != nullptr) {
+          sim_me.anni_near_aged.push_back({gvt::epoch_sending(), sim_me.anni_near_hot_head});
+          sim_me.anni_near_hot_head = nullptr;
+        }
         
         // begin new collective
         gvt::coll_begin(lvt, {executed_n, committed_n});
+        if(cd_steal)
+          proc_lvt[rank_me - deva::process_rank_lo()].store(lvt, std::memory_order_relaxed);
         executed_n = 0;
         committed_n = 0;
       }
@@ -897,18 +1714,71 @@ uint64_t pdes::drain(uint64_t t_end, bool rewindable) {
       #endif // DRAIN_TIMER
     }
     
-    { // execute one event
+    // Over budget nothing executes beyond gvt. The least event anywhere is at
+    // gvt, or will be once the next collective agrees, so progress is kept.
+    uint64_t exec_t_ub = look_t_ub;
+    if(over_budget()) {
+      uint64_t gvt = gvt::epoch_gvt();
+      exec_t_ub = std::min(exec_t_ub, gvt + 1 < gvt ? gvt : gvt + 1);
+    }
+
+    // answer siblings asking for a cd
+    if(!sim_me.steal_asks.empty()) {
+      for(int32_t thief: sim_me.steal_asks) {
+        cd_state *cd = pick_lease(exec_t_ub);
+        if(cd != nullptr)
+          lease_away(cd, thief);
+        else {
+          uint64_t seq = sim_me.drain_seq;
+          deva::send_local(thief, [=]() {
+            if(::sim_me.draining && ::sim_me.drain_seq == seq) {
+              ::sim_me.steal_pending = false;
+              ::sim_me.steal_refused = true;
+            }
+          });
+        }
+      }
+      sim_me.steal_asks.clear();
+    }
+
+    uint64_t executed_n0 = executed_n;
+    
+    // execute up to a quantum of events
+    for(int quantum_i=0; quantum_i < quantum; quantum_i++) {
       cd_state *cd = sim_me.cds_by_now.peek_least().cd;
+      uint64_t cd_look_t_ub = exec_t_ub;
+
+      if(cd_throttle && exec_t_ub == look_t_ub) {
+        // The throttled bound never drops below gvt+1 so the cd holding lvt
+        // can always proceed. Only when the least `now` cd is held back by its
+        // throttle do we look to the least `go_key` cd instead.
+        auto throttled_ub = [&](cd_state *cd) {
+          uint64_t w = sim_me.look_window;
+          return look_t_ub - std::min(cd->throttle, w == 0 ? 0 : w-1);
+        };
+        cd_look_t_ub = throttled_ub(cd);
+
+        if(cd_look_t_ub <= cd->now() && cd_look_t_ub != look_t_ub) {
+          cd_state *cd_go = sim_me.cds_by_go.peek_least().cd;
+          uint64_t go_ub = throttled_ub(cd_go);
+          
+          if(cd_go->now() < go_ub) {
+            cd = cd_go;
+            cd_look_t_ub = go_ub;
+          }
+        }
+      }
+      
       stamped_event se = cd->future_events.peek_least_or({nullptr, end_of_time, end_of_time});
 
       #if DRAIN_TIMER
         sim_me.spinning_empty = cd->future_events.size() == 0;
-        sim_me.spinning_look  = !sim_me.spinning_empty && se.time >= look_t_ub;
+        sim_me.spinning_look  = !sim_me.spinning_empty && se.time >= cd_look_t_ub;
       #else
-        spinning = true;
+        spinning = quantum_i == 0;
       #endif // DRAIN_TIMER
 
-      if(se.time < look_t_ub) {
+      if(se.time < cd_look_t_ub) {
         #if DRAIN_TIMER
           DEVA_ASSERT(!sim_me.spinning_empty && !sim_me.spinning_look);
           sim_me.drain_timer.update(DrainTimer::Cat::execute);
@@ -920,47 +1790,72 @@ uint64_t pdes::drain(uint64_t t_end, bool rewindable) {
         se.e->future_not_past = false;
         
         cd->future_events.pop_least();
-        sim_me.cds_by_now.increased({cd, cd->now()});
+        sim_me.now_increased(cd, cd->now());
         
         insert_past(cd, se);
 
-        event *sent_near; {
+        event *sent_near, *lazy_kept_near; {
           #if DEBUG
           se.e->entry_checksum = cd->checksummer ? cd->checksummer() : 0;
           #endif
           
           #if DEVA_DUMMY_EXEC
-          execute_context cxt_dummy;
+          execute_context_impl cxt_dummy;
           cxt_dummy.cd = cd->cd_ix;
+          cxt_dummy.cd_home = cd->home_rank;
           cxt_dummy.time = se.time;
           cxt_dummy.subtime = se.subtime;
           cxt_dummy.dummy = true;
           se.e->vtbl_on_target->execute(se.e, cxt_dummy);
+          if(close_save_frame(cd, cxt_dummy))
+            restore_save_frame(cd);
           se.e->vtbl_on_target->unexecute(se.e, cxt_dummy, DEVA_DEBUG_ONLY(cd->checksummer,) false);
           #endif
 
           execute_context_impl cxt;
           cxt.cd = cd->cd_ix;
+          cxt.cd_home = cd->home_rank;
           cxt.time = se.time;
           cxt.subtime = se.subtime;
+
+          if(se.e->lazy_sent) {
+            se.e->lazy_sent = false;
+            cxt.lazy_near_head = se.e->sent_near_head;
+            cxt.lazy_far_head = se.e->sent_far_head;
+          }
           
           se.e->vtbl_on_target->execute(se.e, cxt);
+          se.e->state_saved = close_save_frame(cd, cxt);
+
+          // whatever wasn't regenerated gets cancelled
+          if(cxt.lazy_near_head != nullptr || cxt.lazy_far_head != nullptr) {
+            send_anti_lists(cxt.lazy_near_head, cxt.lazy_far_head);
+            flush_antis();
+          }
           
           se.e->sent_near_head = cxt.sent_near_head;
           sent_near = cxt.sent_near_head;
           se.e->sent_far_head = cxt.sent_far_head;
+          lazy_kept_near = cxt.lazy_kept_near_head;
           
           executed_n += 1;
           sim_me.stats.executed_n += 1;
+
+          if(cd_throttle && ++cd->throttle_exec_n == cd_throttle_period)
+            adapt_throttle(cd);
         }
         
         { // walk the `sent_near` list of the event's execution
           event *sent = sent_near;
           while(sent != nullptr) {
             stamped_event sent_se{sent, sent->time, sent->subtime};
+            int32_t sent_home = sent->target_rank;
             int32_t sent_cd_ix = sent->target_cd;
+            cd_state *sent_cd = cd_at(sent_home, sent_cd_ix);
+            int32_t sent_host = host_of(sent_home, sent_cd_ix);
             
-            if(sent->target_rank != rank_me) {
+            // a cd still being leased to us counts as remote
+            if(sent_host != rank_me || sent_cd->host_slot < 0) {
               sent->created_here = false;
               sent->rewind_root = false;
               sent->existence = 0;
@@ -968,8 +1863,8 @@ uint64_t pdes::drain(uint64_t t_end, bool rewindable) {
               sent->remove_after_undo = false;
               
               gvt::send(
-                sent->target_rank, /*local=*/deva::ctrue3, sent->time,
-                [=]() { arrive_near<+1>(sent_cd_ix, sent_se); }
+                sent_host, /*local=*/deva::ctrue3, sent->time,
+                [=]() { arrive_near<+1>(cd_at(sent_home, sent_cd_ix), sent_se); }
               );
               
               sim_me.sent_near.insert(sent);
@@ -981,21 +1876,59 @@ uint64_t pdes::drain(uint64_t t_end, bool rewindable) {
               sent->future_not_past = true;
               sent->remove_after_undo = false;
               
-              cd_state *sent_cd = &sim_me.cds[sent_cd_ix];
               sent_cd->future_events.insert(sent_se);
-              sim_me.cds_by_now.decreased({sent_cd, sent_cd->now_after_future_insert()});
+              sim_me.now_decreased(sent_cd, sent_cd->now_after_future_insert());
             }
             
             sent = sent->sent_near_next;
           }
+          
+          // reclaimed sends are already at their targets, just reattach
+          while(lazy_kept_near != nullptr) {
+            event *next = lazy_kept_near->sent_near_next;
+            lazy_kept_near->sent_near_next = se.e->sent_near_head;
+            se.e->sent_near_head = lazy_kept_near;
+            lazy_kept_near = next;
+          }
         }
 
         #if DRAIN_TIMER
           auto wall_time = sim_me.drain_timer.epoch_begin; // when event began
           auto dt = sim_me.drain_timer.update(DrainTimer::Cat::none, true);
-          sim_me.drain_timer.register_event(cd->cd_ix, se.time, wall_time, dt);
+          sim_me.drain_timer.register_event(cd->host_slot, se.time, wall_time, dt);
         #endif // DRAIN_TIMER
       }
+      else
+        break;
+
+      if(drain_quantum_us > 0 && quantum_i+1 < quantum &&
+         std::chrono::steady_clock::now() - quantum_t0 >= std::chrono::microseconds(drain_quantum_us))
+        break;
+    }
+
+    // idle, ask the sibling furthest behind for a cd
+    if(cd_steal && executed_n == executed_n0 && !sim_me.has_rewind &&
+       !sim_me.steal_pending && !sim_me.steal_refused) {
+      const int32_t rank_lo = deva::process_rank_lo();
+      int32_t victim = -1;
+      uint64_t victim_lvt = sim_me.cds_by_now.least_key();
+      
+      for(int32_t r=rank_lo; r < deva::process_rank_hi(); r++) {
+        uint64_t lvt = proc_lvt[r - rank_lo].load(std::memory_order_relaxed);
+        if(r != rank_me && lvt < victim_lvt) {
+          victim = r;
+          victim_lvt = lvt;
+        }
+      }
+      
+      if(victim != -1 && victim_lvt < exec_t_ub) {
+        sim_me.steal_pending = true;
+        uint64_t seq = sim_me.drain_seq;
+        deva::send_local(victim, [=]() {
+          if(::sim_me.draining && ::sim_me.drain_seq == seq)
+            ::sim_me.steal_asks.push_back(rank_me);
+        });
+      }
     }
   }
 
@@ -1004,10 +1937,8 @@ drain_completed:
     sim_me.drain_timer.update(DrainTimer::Cat::none);
   #endif //DRAIN_TIMER
 
-  for(int cd_ix=0; cd_ix < sim_me.local_cd_n; cd_ix++) {
-    cd_state *cd = &sim_me.cds[cd_ix];
+  for(cd_state *cd: sim_me.hosted)
     DEVA_ASSERT_ALWAYS(cd->future_events.size() == 0);
-  }
   
   DEVA_ASSERT_ALWAYS(sim_me.from_far.size() == 0);
   DEVA_ASSERT_ALWAYS(sim_me.sent_near.size() == 0, "sim_me.sent_near.size() = "<<sim_me.sent_near.size()<<", expected 0");
@@ -1017,10 +1948,13 @@ drain_paused:
     sim_me.drain_timer.update(DrainTimer::Cat::none);
   #endif // DRAIN_TIMER
 
-  for(int cd_ix=0; cd_ix < sim_me.local_cd_n; cd_ix++) {
-    cd_state *cd = &sim_me.cds[cd_ix];
+  // asks still unanswered are moot, their thieves are done too
+  sim_me.draining = false;
+  sim_me.steal_asks.clear();
+  proc_lvt[rank_me - deva::process_rank_lo()].store(uint64_t(-1), std::memory_order_relaxed);
+
+  for(cd_state *cd: sim_me.hosted)
     DEVA_ASSERT_ALWAYS(cd->past_events.size() == 0);
-  }
   
   sim_me.from_far.for_each([&](event_on_creator *o) {
     DEVA_ASSERT_ALWAYS(o->vtbl_on_creator != &anti_vtable, "Lingering from-far anti-message: id="<<o->far_id<<" o="<<o);
@@ -1030,20 +1964,23 @@ drain_paused:
     o->far_next = reinterpret_cast<event_on_creator*>(0x1);
   });
   sim_me.from_far.clear();
+  for(cd_state *cd: sim_me.hosted)
+    cd->far_n = 0;
+
+  // everything before `gvt_returned` is committed
+  fire_milestones(gvt_returned);
 
-  DEVA_ASSERT_ALWAYS(sim_me.anni_near_cold_head == nullptr);
+  DEVA_ASSERT_ALWAYS(sim_me.anni_near_aged.empty());
   DEVA_ASSERT_ALWAYS(sim_me.anni_near_hot_head == nullptr);
 
   #if DEBUG
   {
     int64_t n = 0;
-    for(int32_t cd_ix=0; cd_ix < sim_me.local_cd_n; cd_ix++) {
-      cd_state *cd = &sim_me.cds[cd_ix];
+    for(cd_state *cd: sim_me.hosted)
       n += cd->future_events.size();
-    }
     
-    for(event *e: sim_me.rewind_roots) {
-      if(!e->future_not_past)
+    for(auto const &root: sim_me.rewind_roots) {
+      if(!root.first->future_not_past)
         n += 1;
     }
 
@@ -1059,9 +1996,19 @@ drain_paused:
 
 void pdes::finalize() {
   deva::barrier();
+
+  // every drain has waited out its commits
+  if(sim_me.offload && deva::rank_me_local() == 0) {
+    {
+      std::lock_guard<std::mutex> locked(committer.lock);
+      committer.stopping = true;
+    }
+    committer.wake.notify_one();
+    committer.thread.join();
+  }
+  sim_me.offload = false;
   
-  for(int cd_ix=0; cd_ix < sim_me.local_cd_n; cd_ix++) {
-    cd_state *cd = &sim_me.cds[cd_ix];
+  for(cd_state *cd: sim_me.hosted) {
     DEVA_ASSERT(cd->past_events.size() == 0);
     
     fridge *f = cd->fridge_head;
@@ -1096,19 +2043,32 @@ void pdes::finalize() {
   }
 
   // delete locally created roots
-  for(event *e: sim_me.rewind_roots) {
-    if(e->created_here)
-      e->vtbl_on_creator->destruct_and_delete(e);
+  for(auto const &root: sim_me.rewind_roots) {
+    if(root.first->created_here)
+      root.first->vtbl_on_creator->destruct_and_delete(root.first);
   }
   for(event *e: sim_me.rewind_created_near)
     e->vtbl_on_creator->destruct_and_delete(e);
   sim_me.rewind_created_near.clear();
   sim_me.rewind_roots.clear();
   sim_me.has_rewind = false;
+  sim_me.milestones.clear();
+  
+  sim_me.steal_asks.clear();
+  sim_me.steal_pending = false;
+  sim_me.steal_refused = false;
+  proc_lvt[deva::rank_me() - deva::process_rank_lo()].store(uint64_t(-1), std::memory_order_relaxed);
   
   sim_me.cds_by_dawn.clear();
   sim_me.cds_by_now.clear();
+  sim_me.cds_by_go.clear();
+  sim_me.hosted.clear();
+  
+  deva::barrier(); // our cds may be hosted elsewhere
+  proc_cds[deva::rank_me() - deva::process_rank_lo()] = nullptr;
+  proc_hosts[deva::rank_me() - deva::process_rank_lo()] = nullptr;
   sim_me.cds.reset();
+  sim_me.hosts.reset();
   sim_me.local_cd_n = 0;
 
   #if DEBUG
@@ -1143,8 +2103,7 @@ void pdes::rewind(bool do_rewind) {
   auto &sim_me = ::sim_me;
 
   if(do_rewind) {
-    for(int cd_ix=0; cd_ix < sim_me.local_cd_n; cd_ix++) {
-      cd_state *cd = &sim_me.cds[cd_ix];
+    for(cd_state *cd: sim_me.hosted) {
       cd->last_commit_t = cd->rewind_commit_t;
       cd->seq_id_bumper = cd->seq_id_bumper_rewind;
       
@@ -1180,8 +2139,9 @@ void pdes::rewind(bool do_rewind) {
     }
 
     // move the rewind roots into future
-    for(event *e: sim_me.rewind_roots) {
-      cd_state *cd = &sim_me.cds[e->target_cd];
+    for(auto const &root: sim_me.rewind_roots) {
+      event *e = root.first;
+      cd_state *cd = root.second;
       if(!e->future_not_past)
         sent_far_record::delete_list(e->sent_far_head);
       e->rewind_root = false;
@@ -1193,15 +2153,11 @@ void pdes::rewind(bool do_rewind) {
     sim_me.rewind_roots.clear();
     sim_me.rewind_created_near.clear();
     
-    for(int cd_ix=0; cd_ix < sim_me.local_cd_n; cd_ix++) {
-      cd_state *cd = &sim_me.cds[cd_ix];
-      sim_me.cds_by_now.changed({cd, cd->now()});
-    }
+    for(cd_state *cd: sim_me.hosted)
+      sim_me.now_changed(cd, cd->now());
   }
   else {
-    for(int cd_ix=0; cd_ix < sim_me.local_cd_n; cd_ix++) {
-      cd_state *cd = &sim_me.cds[cd_ix];
-
+    for(cd_state *cd: sim_me.hosted) {
       { // discard fridged user state
         fridge *f = cd->fridge_head;
         while(f != nullptr) {
@@ -1211,7 +2167,8 @@ void pdes::rewind(bool do_rewind) {
       }
     }
     
-    for(event *e: sim_me.rewind_roots) {
+    for(auto const &root: sim_me.rewind_roots) {
+      event *e = root.first;
       if(e->created_here && !e->future_not_past)
         e->vtbl_on_creator->destruct_and_delete(e);
     }
@@ -1227,3 +2184,147 @@ void pdes::rewind(bool do_rewind) {
     sim_me.rewind_created_near.clear();
   }
 }
+
+int32_t pdes::cd_host(int32_t home_rank, int32_t cd_ix) {
+  return host_of(home_rank, cd_ix);
+}
+
+void pdes::migrate(std::vector<migration> const &moves) {
+  sim_state &sim_me = ::sim_me;
+  const int32_t rank_me = deva::rank_me();
+  const int32_t rank_lo = deva::process_rank_lo();
+  
+  DEVA_ASSERT_ALWAYS(!sim_me.has_rewind, "pdes::migrate() can't be called while a rewindable drain awaits pdes::rewind().");
+
+  // cd state is handed over in shared memory, never serialized, so it can't
+  // leave the process
+  for(migration const &m: moves)
+    DEVA_ASSERT_ALWAYS(
+      rank_lo <= m.to_rank && m.to_rank < deva::process_rank_hi(),
+      "CDs can only migrate to ranks of the same process."
+    );
+
+  proc_moves[rank_me - rank_lo] = moves;
+  deva::barrier();
+
+  // give away departing cds, their events go with them as they're quiesced
+  for(migration const &m: moves) {
+    cd_state *cd = cd_at(m.home_rank, m.cd);
+    DEVA_ASSERT_ALWAYS(cd->host_rank == rank_me, "Only the rank hosting a CD may migrate it.");
+
+    sim_me.cds_by_now.erase({cd, 0});
+    sim_me.cds_by_dawn.erase({cd, 0});
+    if(cd_throttle)
+      sim_me.cds_by_go.erase({cd, 0});
+
+    cd_state *last = sim_me.hosted.back();
+    sim_me.hosted[cd->host_slot] = last;
+    last->host_slot = cd->host_slot;
+    sim_me.hosted.pop_back();
+    
+    cd->host_rank = m.to_rank;
+    proc_hosts[m.home_rank - rank_lo][m.cd] = m.to_rank;
+  }
+  
+  deva::barrier();
+
+  // adopt arriving cds
+  for(int r=0; r < deva::worker_n; r++) {
+    for(migration const &m: proc_moves[r]) {
+      if(m.to_rank == rank_me) {
+        cd_state *cd = cd_at(m.home_rank, m.cd);
+        cd->host_slot = sim_me.hosted.size();
+        sim_me.hosted.push_back(cd);
+        sim_me.cds_by_now.insert({cd, cd->now()});
+        sim_me.cds_by_dawn.insert({cd, cd->dawn()});
+        if(cd_throttle)
+          sim_me.cds_by_go.insert({cd, cd->go_key(cd->now())});
+      }
+    }
+  }
+
+  DEVA_ASSERT_ALWAYS(!sim_me.hosted.empty(), "Migration left rank "<<rank_me<<" without any CDs.");
+  
+  deva::barrier();
+  proc_moves[rank_me - rank_lo].clear();
+}
+
+int pdes::rebalance(double tolerance) {
+  sim_state &sim_me = ::sim_me;
+  const int32_t rank_me = deva::rank_me();
+  const int32_t rank_lo = deva::process_rank_lo();
+
+  { // publish the load of each cd we host
+    auto &loads = proc_loads[rank_me - rank_lo];
+    loads.clear();
+    for(cd_state *cd: sim_me.hosted) {
+      #if DRAIN_TIMER
+        double load = std::chrono::duration<double>(
+            sim_me.drain_timer.commit_dt_by_cd_ix[cd->host_slot]
+          ).count();
+      #else
+        double load = double(cd->drain_commit_n);
+      #endif
+      loads.push_back({load, cd});
+    }
+  }
+  
+  deva::barrier();
+
+  // Every rank plans identically from the shared loads and keeps its own moves.
+  std::vector<double> rank_load(deva::worker_n, 0.0);
+  std::vector<std::vector<pair<double,cd_state*>>> plan(deva::worker_n);
+  double total = 0;
+  for(int r=0; r < deva::worker_n; r++) {
+    plan[r] = proc_loads[r];
+    for(auto const &lc: plan[r])
+      rank_load[r] += lc.first;
+    total += rank_load[r];
+  }
+  double mean = total/deva::worker_n;
+  
+  std::vector<migration> moves;
+  // ranks which can no longer shed anything, since the least load only grows
+  // a stuck rank stays stuck
+  std::vector<bool> done(deva::worker_n, false);
+  
+  while(true) {
+    int hi = -1;
+    for(int r=0; r < deva::worker_n; r++) {
+      if(!done[r] && (hi == -1 || rank_load[hi] < rank_load[r]))
+        hi = r;
+    }
+    if(hi == -1 || rank_load[hi] <= (1 + tolerance)*mean)
+      break;
+    int lo = int(std::min_element(rank_load.begin(), rank_load.end()) - rank_load.begin());
+    if(plan[hi].size() <= 1) {
+      done[hi] = true;
+      continue;
+    }
+
+    // the heaviest cd which still narrows the gap between hi and lo
+    double gap = rank_load[hi] - rank_load[lo];
+    int best = -1;
+    for(int i=0; i < (int)plan[hi].size(); i++) {
+      double w = plan[hi][i].first;
+      if(0 < w && w < gap && (best == -1 || plan[hi][best].first < w))
+        best = i;
+    }
+    if(best == -1) {
+      done[hi] = true;
+      continue;
+    }
+
+    auto lc = plan[hi][best];
+    plan[hi][best] = plan[hi].back();
+    plan[hi].pop_back(); // not considered again, it can only move once
+    rank_load[hi] -= lc.first;
+    rank_load[lo] += lc.first;
+    
+    if(hi == rank_me - rank_lo)
+      moves.push_back({lc.second->home_rank, lc.second->cd_ix, rank_lo + lo});
+  }
+
+  migrate(moves); // its barriers also fence our reads of `proc_loads`
+  return int(moves.size());
+}
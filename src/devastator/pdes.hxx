@@ -1,12 +1,35 @@
 #ifndef _409355b8303d41628b1284d487a6d766
 #define _409355b8303d41628b1284d487a6d766
 
+#ifndef DEVA_PDES_FUTURE_HEAP
+  #define DEVA_PDES_FUTURE_HEAP 0
+#endif
+
+#ifndef DEVA_PDES_FUTURE_CALENDAR
+  #define DEVA_PDES_FUTURE_CALENDAR 0
+#endif
+
+#ifndef DEVA_PDES_FUTURE_SOA
+  #define DEVA_PDES_FUTURE_SOA 0
+#endif
+
+#ifndef DEVA_PDES_EVENT_POOL
+  #define DEVA_PDES_EVENT_POOL 0
+#endif
+
+#ifndef DEVA_PDES_HEAP_ARITY
+  #define DEVA_PDES_HEAP_ARITY 2
+#endif
+
+#include <devastator/event_pool.hxx>
 #include <devastator/gvt.hxx>
 #include <devastator/world.hxx>
 #include <devastator/intrusive_min_heap.hxx>
 #include <devastator/queue.hxx>
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <functional>
 #include <iostream>
 #include <utility>
@@ -14,6 +37,7 @@
 #include <vector>
 #include <deque>
 #include <fstream>
+#include <type_traits>
 
 namespace deva {
 namespace pdes {
@@ -71,13 +95,73 @@ namespace pdes {
     template<typename ProcFn>
     void bcast_procs(std::uint64_t time_lb, std::int32_t total_event_n, ProcFn proc_fn);
 
+    /* save: Incremental state saving. Logs the current value of `x` (or the
+     * `n` bytes at `p`) into the cd's undo log, to be restored automatically
+     * if this event is rolled back. Call before modifying the data. Restoration
+     * happens before the event's own `unexecute` runs, so an event which saves
+     * all that it modifies can return `pdes::restore_saved` from `execute()`.
+     */
+    template<typename T>
+    void save(T &x);
+    void save(void *p, std::size_t n);
+
     bool dummy = false;
   };
 
+  /* restore_saved: An execute return type with nothing to reverse beyond the
+   * state logged via `execute_context::save()`.
+   */
+  struct restore_saved {
+    template<typename E>
+    void unexecute(event_context&, E&) {}
+  };
+
   // Set these to determine how frequently and where drain should print global
   // statistics such as gvt and efficiency.
   extern int chitter_secs; // non-positive disables chitter io
   extern std::ostream *chitter_io;
+
+  // Most events drain executes between polls of `deva::progress()`, and
+  // optionally a bound in microseconds on each such run (non-positive for
+  // none). The quantum used adapts downward while events are arriving.
+  // Default from env vars `deva_drain_quantum` (1) and `deva_drain_quantum_us` (0).
+  extern int drain_quantum;
+  extern int drain_quantum_us;
+
+  // Most events committed per drain iteration once gvt advances (non-positive
+  // for no bound). The rest are committed over later iterations, interleaved
+  // with execution, and hold back the next gvt collective until done. Default
+  // from env var `deva_commit_slice` (0).
+  extern int commit_slice;
+
+  // Whether `pdes::init()` starts a committer thread per process to run the
+  // commit()s of events (and delete them) off the ranks. Those commit()s then
+  // run concurrently with execution and must not touch rank thread-local
+  // state, though per cd they still run in timestamp order, so a model opts in
+  // by setting this before `init()` only when its commit()s allow it. Default
+  // false.
+  extern bool commit_offload;
+
+  // Bound in bytes on the events live at each rank (pending execution, commit
+  // or fossil collection). While over it drain stops executing beyond gvt and
+  // commits without slicing, letting gvt rounds reclaim memory until it falls
+  // back under. Non-positive for none. Default from env var
+  // `deva_memory_budget` (0). The measure is approximate: it counts only the
+  // event objects themselves, not undo logs, sent-event records or the user's
+  // own allocations, and an event is charged to the rank constructing it but
+  // credited to whichever rank destroys it, so ranks freeing events created
+  // elsewhere read low and their creators high. Leave headroom accordingly.
+  extern std::int64_t memory_budget;
+
+  // Whether drain lets a rank with nothing to execute lease a CD from the rank
+  // of its process furthest behind, which hands it over mid-drain through the
+  // gvt message channels. Only CDs with no executed but uncommitted events and
+  // no pending far arrivals are leased, and never in rewindable drains. Leased
+  // CDs stay where they went, with the restrictions of `pdes::migrate` on user
+  // state, so a model opts in by setting this before `init()` only when its
+  // events touch no rank thread-local state. Needs the epoch gvt engine
+  // (brutal `pgvt=epoch`). Default false.
+  extern bool cd_steal;
   
   void init(std::int32_t cds_this_rank);
 
@@ -110,21 +194,88 @@ namespace pdes {
    */
   void finalize();
 
-  // root_event: Insert an event into a CD on this rank.
+  /* at_gvt: Not collective. Registers `fn(t)` to be called on this rank from
+   * within `drain()` once gvt passes `t`: after this rank has committed every
+   * event with timestamp less than `t` (their `commit()`s have run) and before
+   * it commits any later one. This lets committed state be observed or
+   * streamed out at sim-time milestones without pausing the simulation. The
+   * callback may register further milestones but must not send events or call
+   * other `pdes` functions. Milestones beyond the end of a drain stay pending
+   * for the next one, `finalize()` discards them, and firings are not undone
+   * by `rewind(true)`.
+   */
+  void at_gvt(std::uint64_t t, std::function<void(std::uint64_t)> fn);
+
+  // root_event: Insert an event into a CD on this rank. The CD must not have
+  // migrated away (see `pdes::migrate`).
   template<typename Event>
   void root_event(std::int32_t cd, std::uint64_t time, Event e);
 
+  /* migrate: Collective. Between calls to `drain()` (and not while a rewindable
+   * drain awaits `rewind()`), hands CDs this rank hosts over to other ranks of
+   * the same process. A CD keeps its name: sends, `cxt.cd` and registration
+   * still use the rank and index it was created with, only the rank executing
+   * its events changes. Nothing is serialized: only the runtime's bookkeeping
+   * of the CD (its pending, executed and uncommitted events) changes hands
+   * through shared memory, registered and user state stays where it lives.
+   * Hence moves are limited to ranks of this process (asserted), and user
+   * state touched by a migratable CD's events must be reachable from every
+   * rank of the process (not `thread_local` or located via `deva::rank_me()`).
+   * Every rank must be left hosting at least one CD.
+   */
+  struct migration {
+    std::int32_t home_rank, cd; // names the cd
+    std::int32_t to_rank;
+  };
+  void migrate(std::vector<migration> const &moves);
+
+  // cd_host: The rank currently executing the events of a CD of this process.
+  std::int32_t cd_host(std::int32_t home_rank, std::int32_t cd);
+
+  /* rebalance: Collective, same restrictions as `migrate`. Greedily moves CDs
+   * from the most to the least loaded ranks of each process until all are
+   * within `tolerance` of the mean, or those still above it have no CD whose
+   * move would help (a rank never gives away its last CD). A CD's load is the
+   * time spent executing its events committed by the last `drain()` as
+   * measured by `DrainTimer` (built with drain_timer=1), otherwise its number
+   * of such events. Returns the number of CDs this rank gave away.
+   */
+  int rebalance(double tolerance = 0.1);
+
   struct statistics {
     std::uint64_t executed_n = 0;
     std::uint64_t committed_n = 0;
+    // Off-rank sends undone by rollback, and how many of those were regenerated
+    // identically upon re-execution and kept instead of cancelled (nonzero only
+    // with lazy cancellation, see `deva_lazy_cancel`).
+    std::uint64_t cancel_n = 0;
+    std::uint64_t cancel_avoided_n = 0;
     bool deterministic = true;
+    // High-water marks of live events and their bytes as seen by drain, and
+    // how many drain iterations were spent over `memory_budget`. The marks
+    // combine by max.
+    std::int64_t live_event_hwm = 0;
+    std::int64_t live_bytes_hwm = 0;
+    std::uint64_t over_budget_n = 0;
+    // CDs this rank adopted from a sibling with `cd_steal`.
+    std::uint64_t steal_n = 0;
 
     statistics& operator+=(statistics x) {
       this->executed_n += x.executed_n;
       this->committed_n += x.committed_n;
+      this->cancel_n += x.cancel_n;
+      this->cancel_avoided_n += x.cancel_avoided_n;
       this->deterministic &= x.deterministic;
+      this->live_event_hwm = std::max(this->live_event_hwm, x.live_event_hwm);
+      this->live_bytes_hwm = std::max(this->live_bytes_hwm, x.live_bytes_hwm);
+      this->over_budget_n += x.over_budget_n;
+      this->steal_n += x.steal_n;
       return *this;
     }
+
+    double cancel_avoided_fraction() const {
+      return cancel_n == 0 ? 0.0 : double(cancel_avoided_n)/double(cancel_n);
+    }
   };
 
 #if DRAIN_TIMER
@@ -170,6 +321,8 @@ namespace pdes {
 
     // [[{sim_time, event_time}]] by cd_ix, then in order of execution
     std::vector<std::deque<EventRecord>> event_times_by_cd_ix;
+    // execute time of committed events by cd_ix since init()
+    std::vector<std::chrono::steady_clock::duration> commit_dt_by_cd_ix;
 
     static std::vector<std::string> get_labels ()
     {
@@ -183,6 +336,25 @@ namespace pdes {
       epoch_begin = start_time;
       cur_cat = Cat::none;
       event_times_by_cd_ix.resize(local_cd_n);
+      commit_dt_by_cd_ix.assign(local_cd_n, std::chrono::steady_clock::duration::zero());
+    }
+
+    // Slots follow `host_slot`, which a leased cd vacates by having the last
+    // slot moved into it.
+    void move_slot (int from, int to)
+    {
+      if (from != to) {
+        event_times_by_cd_ix[to] = std::move(event_times_by_cd_ix[from]);
+        commit_dt_by_cd_ix[to] = commit_dt_by_cd_ix[from];
+      }
+      event_times_by_cd_ix.pop_back();
+      commit_dt_by_cd_ix.pop_back();
+    }
+
+    void push_slot ()
+    {
+      event_times_by_cd_ix.emplace_back();
+      commit_dt_by_cd_ix.push_back(std::chrono::steady_clock::duration::zero());
     }
 
     void accum_by_wall_time (Cat cat, std::chrono::steady_clock::time_point wall_time,
@@ -239,6 +411,7 @@ namespace pdes {
       const EventRecord & record = event_times.front();
       accum_by_sim_time(Cat::execute, record.sim_time, record.dt);
       accum_by_wall_time(Cat::execute, record.wall_time, record.dt);
+      commit_dt_by_cd_ix[cd_ix] += record.dt;
       event_times.pop_front();
     }
 
@@ -340,12 +513,24 @@ namespace pdes {
     extern __thread std::uint64_t far_id_bumper;
     constexpr std::uint64_t far_id_delta = deva::rank_n;
 
+    struct execute_context_impl;
+
     extern std::uint64_t seq_id_delta;
-    std::uint64_t next_seq_id(std::int32_t cd_ix, int n);
+    std::uint64_t next_seq_id(execute_context_impl *cxt, int n);
+
+    // Lazy cancellation: when set (env var `deva_lazy_cancel`), rollback holds
+    // back the anti-messages of an undone event's off-rank sends until it
+    // re-executes, and any send regenerated identically keeps the original.
+    extern const bool lazy_cancel;
+
+    template<typename E>
+    std::uint64_t payload_hash(E const &user);
     
     void root_event(std::int32_t cd_ix, event *e);
-    bool/*annihilated*/ arrive_far(std::uint64_t far_id, std::uint64_t time, std::int32_t cd, event *e);
-    bool/*annihilated*/ arrive_far_anti(std::uint64_t far_id, std::uint64_t time);
+    // Both return 1 if annihilated, 0 if not, -1 if passed along to the rank
+    // the cd migrated to.
+    int arrive_far(std::uint64_t far_id, std::uint64_t time, std::int32_t cd, event *e);
+    int arrive_far_anti(std::uint64_t far_id, std::uint64_t time, std::int32_t cd);
     
     struct event_vtable {
       void(*destruct_and_delete)(event*);
@@ -373,13 +558,14 @@ namespace pdes {
         std::uint64_t far_id;
       };
       std::int32_t target_cd;
-      // <free 32-bit padding here>
+      std::int32_t far_home; // home rank of the target cd, if from far
       event_on_creator *far_next = reinterpret_cast<event_on_creator*>(0x1); // 0x1 == not from far
       union {
         event *sent_near_next = nullptr;
         event *anni_near_next; // annihilated list next pointer
         event *del_next;
       };
+      std::uint64_t payload_hash = 0; // lazy cancellation match, 0 = never matches
       
       static event_on_creator*& far_next_of(event_on_creator *me) {
         return me->far_next;
@@ -394,7 +580,9 @@ namespace pdes {
                    rewind_root:1, // bool
                    existence:2, // -1,0,+1
                    future_not_past:1, // bool
-                   remove_after_undo:1; // bool
+                   remove_after_undo:1, // bool
+                   lazy_sent:1, // bool, sent_{near|far}_head hold off-rank sends pending lazy cancellation
+                   state_saved:1; // bool, has a frame in the cd's undo log
       std::int32_t future_ix;
       #if DEBUG
         std::uint64_t entry_checksum;
@@ -402,7 +590,9 @@ namespace pdes {
       
       event_on_target():
         existence(0),
-        remove_after_undo(false) {
+        remove_after_undo(false),
+        lazy_sent(false),
+        state_saved(false) {
       }
       
       ~event_on_target() {
@@ -410,23 +600,17 @@ namespace pdes {
       }
     };
 
-    #if DEBUG
     extern __thread std::int64_t live_event_balance; // num(construct) - num(destructed)
-    #endif
+    extern __thread std::int64_t live_event_bytes; // and their sizes
 
     struct event: event_on_creator, event_on_target {
       event(event_vtable const *vtbl) {
         this->vtbl_on_creator = vtbl;
         this->vtbl_on_target = vtbl;
-        
-        #if DEBUG
-          live_event_balance += 1;
-        #endif
+        live_event_balance += 1;
       }
       
-      #if DEBUG
-        ~event() { live_event_balance -= 1; }
-      #endif
+      ~event() { live_event_balance -= 1; }
 
       static std::uint64_t time_of(event *e) {
         return e->time;
@@ -439,8 +623,16 @@ namespace pdes {
 
     struct sent_far_one final: sent_far_record {
       std::int32_t rank;
+      std::int32_t cd;
       std::uint64_t far_id;
-      std::uint64_t time;
+      std::uint64_t time, subtime;
+      event_vtable const *vtbl_event; // identifies event type
+      std::uint64_t payload_hash;
+      unsigned char *payload = nullptr; // copy of the event's bytes if payload_hash != 0
+
+      ~sent_far_one() {
+        delete[] payload;
+      }
 
       static void the_delete1(sent_far_record *me1) {
         delete static_cast<sent_far_one*>(me1);
@@ -450,10 +642,11 @@ namespace pdes {
         auto *me = static_cast<sent_far_one*>(me1);
         std::uint64_t far_id = me->far_id;
         std::uint64_t time = me->time;
+        std::int32_t cd = me->cd;
         
         gvt::send(
           me->rank, /*local=*/deva::cfalse3, time,
-          [=]() { detail::arrive_far_anti(far_id, time); }
+          [=]() { detail::arrive_far_anti(far_id, time, cd); }
         );
         
         delete me;
@@ -498,9 +691,34 @@ namespace pdes {
     constexpr sent_far_record::vtable sent_far_bcast_procs<ProcFn>::the_vtbl;
     
     struct execute_context_impl: execute_context {
+      std::int32_t cd_home; // rank which created `cd`
       event *sent_near_head = nullptr;
       sent_far_record *sent_far_head = nullptr;
+      // sends of a previous execution pending lazy cancellation, and those
+      // reclaimed by this execution
+      event *lazy_near_head = nullptr;
+      sent_far_record *lazy_far_head = nullptr;
+      event *lazy_kept_near_head = nullptr;
+      // undo log index where this execution's frame begins, -1 if none
+      int save_frame_ix = -1;
     };
+
+    void save_bytes(execute_context_impl *cxt, void *p, std::size_t n);
+
+    // Search the pending sends of `cxt` for one matching exactly (hash first,
+    // then the event bytes at `user`), if found it's moved to the kept/sent
+    // lists and true returned.
+    bool lazy_reclaim_near(execute_context_impl *cxt,
+                           std::int32_t rank, std::int32_t cd,
+                           std::uint64_t time, std::uint64_t subtime,
+                           event_vtable const *vtbl, std::uint64_t payload_hash,
+                           bool(*same_user)(event const*, void const*),
+                           void const *user);
+    bool lazy_reclaim_far(execute_context_impl *cxt,
+                          std::int32_t rank, std::int32_t cd,
+                          std::uint64_t time, std::uint64_t subtime,
+                          event_vtable const *vtbl, std::uint64_t payload_hash,
+                          void const *user, std::size_t size);
     
     template<typename E, typename=void>
     struct event_has_commit: std::false_type {};
@@ -593,13 +811,19 @@ namespace pdes {
       );
       
       using ExecRet = typename std::remove_const<decltype(std::declval<E>().execute(std::declval<execute_context&>()))>::type;
-      E user;
+      union { E user; }; // union so it can be deserialized in place
       union { ExecRet exec_ret; };
 
       static void destruct_and_delete(event *me1) {
         auto *me = static_cast<event_impl<E>*>(me1);
         delete me;
       }
+
+      // confirms a lazy cancellation match whose `payload_hash` agreed
+      static bool same_user(event const *me1, void const *user) {
+        auto const *me = static_cast<event_impl<E> const*>(me1);
+        return 0 == std::memcmp(&me->user, user, sizeof(E));
+      }
       
       static void execute(event *me1, execute_context &cxt) {
         auto *me = static_cast<event_impl<E>*>(me1);
@@ -638,13 +862,75 @@ namespace pdes {
       event_impl(E user):
         event(&the_vtbl),
         user(std::move(user)) {
+        live_event_bytes += sizeof(event_impl);
+      }
+
+      template<typename Reader>
+      event_impl(Reader &r, std::true_type deserialize):
+        event(&the_vtbl) {
+        static_assert(std::is_same<decltype(r.template read_into<E>(nullptr)), E*>::value, "Events sent far must deserialize as their own type.");
+        r.template read_into<E>(&this->user);
+        live_event_bytes += sizeof(event_impl);
+      }
+
+      ~event_impl() {
+        user.~E();
+        live_event_bytes -= sizeof(event_impl);
       }
 
-      ~event_impl() {}
+    #if DEVA_PDES_EVENT_POOL
+      // events come and go at a high rate, keep them off the general heap
+      static void* operator new(std::size_t size) {
+        DEVA_ASSERT(size == sizeof(event_impl));
+        (void)size;
+        return event_pool<event_impl>::allocate();
+      }
+      static void operator delete(void *o) {
+        event_pool<event_impl>::deallocate(o);
+      }
+    #endif
     };
 
     template<typename E>
     constexpr event_vtable event_impl<E>::the_vtbl;
+
+    /* far_event<E>: What crosses the wire for an event sent far. The sender
+     * wraps a pointer to the user's event and the receiver deserializes the
+     * payload straight into a fresh `event_impl<E>`, so large events are
+     * copied out of the receive buffer once rather than into a temporary and
+     * then again into the event.
+     */
+    template<typename E>
+    struct far_event {
+      E const *user; // sender side
+      event_impl<E> *e; // receiver side
+
+      struct upcxx_serialization {
+        template<typename Ub>
+        static auto ubound(Ub ub, far_event const &x)
+          -> decltype(ub.cat_ubound_of(*x.user)) {
+          return ub.cat_ubound_of(*x.user);
+        }
+
+        template<typename Writer>
+        static void serialize(Writer &w, far_event const &x) {
+          w.write(*x.user);
+        }
+
+        template<typename Reader>
+        static void skip(Reader &r) {
+          r.template skip<E>();
+        }
+
+        using deserialized_type = far_event;
+
+        template<typename Reader>
+        static far_event* deserialize(Reader &r, void *spot) {
+          auto *e = new event_impl<E>(r, std::true_type());
+          return ::new(spot) far_event{nullptr, e};
+        }
+      };
+    };
   }
   
   //////////////////////////////////////////////////////////////////////////////
@@ -673,7 +959,7 @@ namespace pdes {
     using Event = typename std::decay<Event1>::type;
     
     auto *me = static_cast<detail::execute_context_impl*>(this);
-    std::uint64_t subtime = detail::event_subtime<Event>()(detail::next_seq_id(this->cd, +1), user);
+    std::uint64_t subtime = detail::event_subtime<Event>()(detail::next_seq_id(me, +1), user);
     #if TIMELINE
       std::uint64_t gen_rank = deva::rank_me();
       std::uint64_t gen_cd   = this->cd;
@@ -688,12 +974,29 @@ namespace pdes {
       "must be strictly increasing."
     );
     
+    std::uint64_t hash = detail::payload_hash<Event>(user);
+    
+    if(hash != 0) {
+      // a previous execution may have sent this very event already (only sends
+      // to cds hosted elsewhere are ever held, so self-sends can't match)
+      auto *vtbl = &detail::event_impl<Event>::the_vtbl;
+      if(deva::rank_is_local(rank)
+          ? me->lazy_near_head != nullptr &&
+            detail::lazy_reclaim_near(me, rank, cd, time, subtime, vtbl, hash,
+                                      &detail::event_impl<Event>::same_user, &user)
+          : me->lazy_far_head != nullptr &&
+            detail::lazy_reclaim_far(me, rank, cd, time, subtime, vtbl, hash,
+                                     &user, sizeof(Event)))
+        return;
+    }
+    
     if(deva::rank_is_local(rank)) {
       auto *e = new detail::event_impl<Event>{static_cast<Event1&&>(user)};
       e->target_rank = rank;
       e->target_cd = cd;
       e->time = time;
       e->subtime = subtime;
+      e->payload_hash = hash;
       #if TIMELINE
         e->gen_rank = gen_rank;
         e->gen_cd   = gen_cd;
@@ -709,8 +1012,8 @@ namespace pdes {
       detail::far_id_bumper += detail::far_id_delta;
       
       gvt::send(rank, /*local=*/deva::cfalse3, time,
-        [=](Event &&user) {
-          auto *e = new detail::event_impl<Event>{static_cast<Event&&>(user)};
+        [=](detail::far_event<Event> &&far) {
+          auto *e = far.e;
           e->subtime = subtime;
           #if TIMELINE
             e->gen_rank = gen_rank;
@@ -719,13 +1022,21 @@ namespace pdes {
           #endif
           detail::arrive_far(far_id, time, cd, e);
         },
-        static_cast<Event1&&>(user)
+        detail::far_event<Event>{&user, nullptr}
       );
 
       auto *far = new detail::sent_far_one;
       far->rank = rank;
+      far->cd = cd;
       far->far_id = far_id;
       far->time = time;
+      far->subtime = subtime;
+      far->vtbl_event = &detail::event_impl<Event>::the_vtbl;
+      far->payload_hash = hash;
+      if(hash != 0) {
+        far->payload = new unsigned char[sizeof(Event)];
+        std::memcpy(far->payload, &user, sizeof(Event));
+      }
       far->next = me->sent_far_head;
       me->sent_far_head = far;
     }
@@ -733,6 +1044,33 @@ namespace pdes {
 
   //////////////////////////////////////////////////////////////////////////////
 
+  template<typename T>
+  void execute_context::save(T &x) {
+    static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types can be saved.");
+    detail::save_bytes(static_cast<detail::execute_context_impl*>(this), &x, sizeof(T));
+  }
+  
+  inline void execute_context::save(void *p, std::size_t n) {
+    detail::save_bytes(static_cast<detail::execute_context_impl*>(this), p, n);
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+
+  template<typename E>
+  std::uint64_t detail::payload_hash(E const &user) {
+    if(!std::is_trivially_copyable<E>::value || !lazy_cancel)
+      return 0;
+    
+    // fnv-1a over the event's bytes, differing padding just forfeits a match
+    unsigned char const *p = reinterpret_cast<unsigned char const*>(&user);
+    std::uint64_t h = 0xcbf29ce484222325u;
+    for(std::size_t i=0; i < sizeof(E); i++)
+      h = (h ^ p[i])*0x100000001b3u;
+    return h | 1;
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+
   template<typename ProcFn>
   void execute_context::bcast_procs(
       std::uint64_t time_lb, std::int32_t total_event_n, ProcFn proc_fn
@@ -743,7 +1081,7 @@ namespace pdes {
     std::uint64_t far_id_base = detail::far_id_bumper;
     detail::far_id_bumper += total_event_n*detail::far_id_delta;
     
-    std::uint64_t seq_id_base = detail::next_seq_id(this->cd, total_event_n);
+    std::uint64_t seq_id_base = detail::next_seq_id(me, total_event_n);
 
     gvt::bcast_procs(time_lb, /*credits=*/total_event_n,
       deva::bind(
@@ -781,12 +1119,12 @@ namespace pdes {
                     e->time = time;
                     e->subtime = detail::event_subtime<Event>()(seq_id, e_user);
 
-                    bool anni = detail::arrive_far(far_id, time, cd, e);
-                    anni_all_t &= anni;
-                    anni_all_f &= !anni;
+                    int anni = detail::arrive_far(far_id, time, cd, e);
+                    anni_all_t &= anni != 0;
+                    anni_all_f &= anni != 1;
                   });
                   
-                  DEVA_ASSERT(anni_all_t ^ anni_all_f);
+                  DEVA_ASSERT(anni_all_t || anni_all_f);
                   DEVA_ASSERT_ALWAYS(
                     local_event_n == local_event_n_actual,
                     "Event count given to `run_at_rank(events="<<local_event_n<<")` "
@@ -837,12 +1175,12 @@ namespace pdes {
                     std::uint64_t far_id = far_id_bumper;
                     far_id_bumper += detail::far_id_delta;
                     
-                    bool anni = detail::arrive_far_anti(far_id, time);
-                    anni_all_t &= anni;
-                    anni_all_f &= !anni;
+                    int anni = detail::arrive_far_anti(far_id, time, cd);
+                    anni_all_t &= anni != 0;
+                    anni_all_f &= anni != 1;
                   });
 
-                  DEVA_ASSERT(anni_all_t ^ anni_all_f);
+                  DEVA_ASSERT(anni_all_t || anni_all_f);
                   
                   return local_event_n;
                 }
@@ -921,6 +1259,25 @@ namespace pdes {
       static std::int32_t& future_ix_of(stamped_event se) {
         return se.e->future_ix;
       }
+      static std::uint64_t time_of(stamped_event se) {
+        return se.time;
+      }
+
+      // Just the ordering part, for queues keeping keys apart from events.
+      struct stamp {
+        std::uint64_t time;
+        std::uint64_t subtime;
+
+        constexpr friend bool operator<(stamp a, stamp b) {
+          bool ans = a.subtime < b.subtime;
+          ans &= a.time == b.time;
+          ans |= a.time < b.time;
+          return ans;
+        }
+      };
+      static stamp stamp_of(stamped_event se) {
+        return {se.time, se.subtime};
+      }
 
       constexpr bool definitely_ordered_wrt(stamped_event that) const {
         return this->time != that.time || this->subtime != that.subtime;
@@ -3,12 +3,23 @@
 #include <devastator/opnew.hxx>
 #include <devastator/os_env.hxx>
 
+#include <algorithm>
 #include <atomic>
+#include <cstdio>
+#include <string>
+#include <vector>
 
 #include <external/pthread.h>
 #include <sched.h>
 #include <sys/mman.h>
+#include <sys/syscall.h>
 #include <errno.h>
+#include <unistd.h>
+
+#if DEVA_THREADS_IDLE_BLOCK
+  #include <linux/futex.h>
+  #include <time.h>
+#endif
 
 namespace opnew = deva::opnew;
 namespace threads = deva::threads;
@@ -75,6 +86,67 @@ void threads::progress_end(threads::progress_state ps) {
   opnew::progress();
 }
 
+namespace {
+  int idle_spin_n = deva::os_env<int>("deva_idle_spin", 10);
+  #if DEVA_THREADS_IDLE_BLOCK
+    int idle_yield_n = deva::os_env<int>("deva_idle_yield", 10);
+    int idle_block_us = deva::os_env<int>("deva_idle_block_us", 100);
+  #endif
+  __thread int idle_n = 0;
+}
+
+#if DEVA_THREADS_IDLE_BLOCK
+void threads::doorbell::ring_slow() {
+  rung_.fetch_add(1, std::memory_order_relaxed);
+  syscall(SYS_futex, &rung_, FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+}
+
+bool threads::doorbell::sleep(std::uint32_t seen, int timeout_us) {
+  timespec timeout;
+  timeout.tv_sec = timeout_us/1000000;
+  timeout.tv_nsec = 1000*(timeout_us%1000000);
+  // returns early (EAGAIN) if rung since `seen`
+  syscall(SYS_futex, &rung_, FUTEX_WAIT_PRIVATE, seen, &timeout, nullptr, 0);
+  asleep_.store(false, std::memory_order_relaxed);
+  return rung_.load(std::memory_order_relaxed) != seen;
+}
+#endif
+
+void threads::progress_idle(bool idle, bool(*poll)()) {
+  (void)poll; // only blocking polls
+  
+  if(!idle) {
+    idle_n = 0;
+    return;
+  }
+  
+  idle_n += 1;
+  
+  #if DEVA_THREADS_IDLE_YIELD
+    if(idle_n >= idle_spin_n) {
+      idle_n = 0;
+      sched_yield();
+    }
+  #elif DEVA_THREADS_IDLE_BLOCK
+    if(idle_n <= idle_spin_n)
+      return;
+    if(idle_n <= idle_spin_n + idle_yield_n) {
+      sched_yield();
+      return;
+    }
+    
+    doorbell *bell = &ams_r[thread_me_].bell();
+    std::uint32_t seen = bell->doze();
+    if(poll()) {
+      bell->wake_up();
+      idle_n = 0;
+    }
+    else if(bell->sleep(seen, idle_block_us))
+      idle_n = 0; // back to spinning since more is likely on its way
+    // else timed out, poll and block again
+  #endif
+}
+
 void threads::barrier(void(*progress_work)(threads::progress_state&)) {
   barrier_l_.begin(barrier_g_, thread_me_);
 
@@ -96,6 +168,9 @@ void threads::barrier(void(*progress_work)(threads::progress_state&)) {
 
 namespace {
   cpu_set_t cpu_mask;
+  int thread_cpu[threads::thread_n]; // -1 if unpinned
+  int thread_node[threads::thread_n]; // -1 if unknown
+  int node_n = 1;
   pthread_t thread_ids[threads::thread_n];
   pthread_mutex_t lock;
   pthread_cond_t wake;
@@ -108,6 +183,106 @@ namespace {
     std::size_t msg_arena_capacity;
   #endif
   
+  bool numa_mem_local;
+
+  // Parses a sysfs cpu/node list like "0-3,8,10-11" calling `fn` on each.
+  template<typename Fn>
+  void sysfs_list(const char *path, Fn fn) {
+    FILE *f = std::fopen(path, "r");
+    if(f == nullptr) return;
+    int lo, hi;
+    while(std::fscanf(f, "%d", &lo) == 1) {
+      hi = lo;
+      int c = std::fgetc(f);
+      if(c == '-') {
+        if(std::fscanf(f, "%d", &hi) != 1) break;
+        c = std::fgetc(f);
+      }
+      for(int i=lo; i <= hi; i++)
+        fn(i);
+      if(c != ',') break;
+    }
+    std::fclose(f);
+  }
+
+  // Sets the preferred node for pages of `[p, p+size)`, or for this thread's
+  // future allocations when `p` is null. Failures (no NUMA in the kernel,
+  // seccomp) just leave first touch in charge.
+  void prefer_node(void *p, std::size_t size, int node) {
+    constexpr int mpol_preferred = 1; // MPOL_PREFERRED in <linux/mempolicy.h>
+    unsigned long mask[1024/(8*sizeof(unsigned long))] = {};
+    mask[node/(8*sizeof(unsigned long))] = 1ul<<(node%(8*sizeof(unsigned long)));
+    unsigned long maxnode = 8*sizeof(mask) + 1;
+    if(p == nullptr)
+      syscall(SYS_set_mempolicy, mpol_preferred, mask, maxnode);
+    else
+      syscall(SYS_mbind, p, size, mpol_preferred, mask, maxnode, 0);
+  }
+
+  // Assigns each thread a cpu from our affinity mask per `deva_pin`:
+  //   "compact": fill one node's cpus before the next (default).
+  //   "scatter": deal threads round robin over the nodes.
+  //   "none": leave placement to the OS.
+  // We only pin when the mask has at least a cpu per thread. Independently,
+  // `deva_numa_mem` picks where thread memory goes:
+  //   "local": prefer the node of the thread's cpu (default).
+  //   "none": leave it to first touch.
+  void place_threads() {
+    int cpu_node[CPU_SETSIZE];
+    for(int cpu=0; cpu < CPU_SETSIZE; cpu++)
+      cpu_node[cpu] = 0;
+
+    node_n = 0;
+    sysfs_list("/sys/devices/system/node/online", [&](int node) {
+      char path[64];
+      std::snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+      sysfs_list(path, [&](int cpu) {
+        if(cpu < CPU_SETSIZE)
+          cpu_node[cpu] = node;
+      });
+      node_n = std::max(node_n, node+1);
+    });
+    node_n = std::max(node_n, 1);
+
+    // our cpus bucketed by node, each bucket in cpu order
+    std::vector<std::vector<int>> node_cpus(node_n);
+    int cpu_n = 0;
+    for(int cpu=0; cpu < CPU_SETSIZE; cpu++) {
+      if(CPU_ISSET(cpu, &cpu_mask)) {
+        node_cpus[cpu_node[cpu]].push_back(cpu);
+        cpu_n += 1;
+      }
+    }
+
+    std::string pin = deva::os_env<std::string>("deva_pin", "compact");
+    DEVA_ASSERT_ALWAYS(pin == "compact" || pin == "scatter" || pin == "none",
+      "Invalid deva_pin="<<pin<<", expected compact|scatter|none.");
+
+    std::string numa_mem = deva::os_env<std::string>("deva_numa_mem", "local");
+    DEVA_ASSERT_ALWAYS(numa_mem == "local" || numa_mem == "none",
+      "Invalid deva_numa_mem="<<numa_mem<<", expected local|none.");
+    numa_mem_local = numa_mem == "local";
+
+    std::vector<int> order;
+    if(pin == "scatter") {
+      for(int i=0; (int)order.size() < cpu_n; i++) {
+        for(auto const &cpus: node_cpus)
+          if(i < (int)cpus.size())
+            order.push_back(cpus[i]);
+      }
+    }
+    else {
+      for(auto const &cpus: node_cpus)
+        order.insert(order.end(), cpus.begin(), cpus.end());
+    }
+
+    bool pinning = pin != "none" && cpu_n >= threads::thread_n;
+    for(int t=0; t < threads::thread_n; t++) {
+      thread_cpu[t] = pinning ? order[t] : -1;
+      thread_node[t] = pinning ? cpu_node[order[t]] : -1;
+    }
+  }
+
   void* tmain(void *me1) {
     int me = reinterpret_cast<std::intptr_t>(me1);
     static bool zero_inited = false;
@@ -116,30 +291,16 @@ namespace {
       if(me == 0)
         zero_inited = true;
 
-      { // pin ourself to the me'th cpu of our process's affinity mask
-        int cpu_n = 0;
-        int cpu = 0;
-        while(cpu != CPU_SETSIZE) {
-          cpu_n += CPU_ISSET(cpu, &cpu_mask) ? 1 : 0;
-          cpu++;
-        }
-
-        if(cpu_n >= threads::thread_n) {
-          cpu = 0;
-          cpu_n = 0;
-          while(true) {
-            if(CPU_ISSET(cpu, &cpu_mask))
-              if(me == cpu_n++)
-                break;
-            cpu++;
-          }
-
-          cpu_set_t just_me;
-          CPU_ZERO(&just_me);
-          CPU_SET(cpu, &just_me);
-          sched_setaffinity(0, sizeof(cpu_set_t), &just_me);
-        }
+      if(thread_cpu[me] >= 0) {
+        cpu_set_t just_me;
+        CPU_ZERO(&just_me);
+        CPU_SET(thread_cpu[me], &just_me);
+        sched_setaffinity(0, sizeof(cpu_set_t), &just_me);
       }
+
+      // so what we allocate from here on (like `sim_me`'s heaps) is local
+      if(numa_mem_local && node_n > 1 && thread_node[me] >= 0)
+        prefer_node(nullptr, 0, thread_node[me]);
       
       threads::thread_me_ = me;
 
@@ -216,6 +377,7 @@ void threads::run(upcxx::detail::function_ref<void()> fn) {
     inited = true;
 
     sched_getaffinity(0, sizeof(cpu_set_t), &cpu_mask);
+    place_threads();
     
     (void)pthread_cond_init(&wake, nullptr);
     (void)pthread_mutex_init(&lock, nullptr);
@@ -228,6 +390,9 @@ void threads::run(upcxx::detail::function_ref<void()> fn) {
       for(int t=0; t < thread_n; t++) {
         void *arena = mmap(nullptr, msg_arena_capacity, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
         DEVA_ASSERT_ALWAYS(arena != MAP_FAILED, "mmap of DEVA_TMSG_ARENA_MB="<<msg_arena_capacity<<" failed, errno="<<errno);
+        // we map them all but each should live with its thread, not us
+        if(numa_mem_local && node_n > 1 && thread_node[t] >= 0)
+          prefer_node(arena, msg_arena_capacity, thread_node[t]);
         msg_arena_bases[t] = arena;
       }
     }
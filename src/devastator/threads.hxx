@@ -46,6 +46,11 @@ namespace threads {
   template<typename Fn>
   void send(int thread, Fn &&fn);
 
+  // Collects messages bound for one thread and publishes them together on
+  // `flush()` (or destruction), paying the channel's atomics once for the
+  // lot. Execution order matches sending them one by one.
+  class send_batch;
+
   struct progress_state {
     bool did_something = false;
     bool backlogged = false;
@@ -58,6 +63,14 @@ namespace threads {
   void progress_stage1_reclaims(progress_state &ps);
   void progress_stage2_recieves(progress_state &ps);
   void progress_end(progress_state ps);
+
+  // Called after each poll of this thread's channels with whether it found
+  // nothing to do while spinning. Per `tidle`: busy polls (spin), yields
+  // every `deva_idle_spin` idle polls (yield), or spins `deva_idle_spin`,
+  // yields `deva_idle_yield` and then blocks until a message is sent to us or
+  // `deva_idle_block_us` pass (block). `poll` polls once more (returning
+  // whether it did something) to close the race with senders before sleeping.
+  void progress_idle(bool idle, bool(*poll)());
   
   void barrier(void(*progress_work)(threads::progress_state&));
   
@@ -132,6 +145,13 @@ namespace threads {
     #if 1 && DEVA_THREADS_ALLOC_EPOCH
       // nop
     #else
+      #if DEVA_THREADS_INLINE_SIZE
+        // from some thread's inline ring
+        if(std::uintptr_t((char*)m - (char*)ams_w) < sizeof(ams_w)) {
+          inline_ring::dealloc(m);
+          return;
+        }
+      #endif
       opnew::template operator_delete</*known_size=*/0, /*known_local=*/DEVA_THREADS_ALLOC_OPNEW_SYM>(m);
     #endif
   }
@@ -160,10 +180,51 @@ namespace threads {
   void send(int thread, Fn1 &&fn) {
     using Fn = typename std::decay<Fn1>::type;
     using Msg = active_message_impl<Fn>;
-    void *m = alloc_message(sizeof(Msg), alignof(Msg));
+    void *m = ams_w[thread_me_].template alloc_inline<sizeof(Msg), alignof(Msg)>(thread);
+    if(m == nullptr)
+      m = alloc_message(sizeof(Msg), alignof(Msg));
     ams_w[thread_me_].send(thread, ::new(m) Msg{static_cast<Fn1&&>(fn)});
   }
   
+  class send_batch {
+    int thread_;
+    int n_ = 0;
+    message *head_ = nullptr, *tail_ = nullptr;
+
+  public:
+    explicit send_batch(int thread): thread_(thread) {}
+    send_batch(send_batch const&) = delete;
+    send_batch(send_batch &&that):
+      thread_(that.thread_), n_(that.n_), head_(that.head_), tail_(that.tail_) {
+      that.n_ = 0;
+    }
+    ~send_batch() { flush(); }
+
+    int size() const { return n_; }
+    
+    template<typename Fn1>
+    void send(Fn1 &&fn) {
+      using Fn = typename std::decay<Fn1>::type;
+      using Msg = active_message_impl<Fn>;
+      void *m = ams_w[thread_me_].template alloc_inline<sizeof(Msg), alignof(Msg)>(thread_);
+      if(m == nullptr)
+        m = alloc_message(sizeof(Msg), alignof(Msg));
+      message *msg = ::new(m) Msg{static_cast<Fn1&&>(fn)};
+      if(n_++ == 0)
+        head_ = msg;
+      else
+        tail_->next = msg;
+      tail_ = msg;
+    }
+
+    void flush() {
+      if(n_ != 0) {
+        ams_w[thread_me_].send_chain(thread_, head_, tail_, n_);
+        n_ = 0;
+      }
+    }
+  };
+
   template<typename Fn>
   void bcast_peers(Fn fn) {
     for(int t=0; t < thread_n; t++) {
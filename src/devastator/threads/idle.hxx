@@ -0,0 +1,67 @@
+#ifndef _b61e0c2a8d7f4e3c9a51f2d07c4e96b3
+#define _b61e0c2a8d7f4e3c9a51f2d07c4e96b3
+
+#ifndef DEVA_THREADS_IDLE_SPIN
+  #define DEVA_THREADS_IDLE_SPIN 0
+#endif
+#ifndef DEVA_THREADS_IDLE_YIELD
+  #define DEVA_THREADS_IDLE_YIELD 0
+#endif
+#ifndef DEVA_THREADS_IDLE_BLOCK
+  #define DEVA_THREADS_IDLE_BLOCK 0
+#endif
+
+#if !DEVA_THREADS_IDLE_SPIN && !DEVA_THREADS_IDLE_BLOCK
+  #undef DEVA_THREADS_IDLE_YIELD
+  #define DEVA_THREADS_IDLE_YIELD 1
+#endif
+
+#include <atomic>
+#include <cstdint>
+
+namespace deva {
+namespace threads {
+  /* doorbell: What a thread idling in `progress_idle()` blocks on, one per
+   * `channels_r`. Writers ring it after publishing messages to the channel,
+   * which costs a fence and a load unless the reader is asleep. Only
+   * `tidle=block` has any state.
+   */
+  class doorbell {
+  #if DEVA_THREADS_IDLE_BLOCK
+    std::atomic<std::uint32_t> rung_{0}; // futex word
+    std::atomic<bool> asleep_{false};
+
+    void ring_slow();
+  #endif
+
+  public:
+    void ring() {
+    #if DEVA_THREADS_IDLE_BLOCK
+      // orders our publish before reading `asleep_`, pairs with `doze()`
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if(asleep_.load(std::memory_order_relaxed))
+        ring_slow();
+    #endif
+    }
+
+  #if DEVA_THREADS_IDLE_BLOCK
+    // Reader announces it is about to sleep. It must poll its channels once
+    // more after this and then either `sleep()` or `wake_up()`.
+    std::uint32_t doze() {
+      std::uint32_t seen = rung_.load(std::memory_order_relaxed);
+      asleep_.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      return seen;
+    }
+
+    void wake_up() {
+      asleep_.store(false, std::memory_order_relaxed);
+    }
+
+    // Blocks until rung since `doze()` returned `seen` or `timeout_us` pass.
+    // Returns whether we were rung.
+    bool sleep(std::uint32_t seen, int timeout_us);
+  #endif
+  };
+}}
+#endif
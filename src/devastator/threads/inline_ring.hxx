@@ -0,0 +1,65 @@
+#ifndef _0e93c5d1a7b84f26b3d8e6a41c9f2d70
+#define _0e93c5d1a7b84f26b3d8e6a41c9f2d70
+
+#ifndef DEVA_THREADS_INLINE_SIZE
+  #define DEVA_THREADS_INLINE_SIZE 64
+#endif
+#ifndef DEVA_THREADS_INLINE_N
+  #define DEVA_THREADS_INLINE_N 64
+#endif
+
+#if DEVA_THREADS_ALLOC_EPOCH // the epoch arena is already allocation free
+  #undef DEVA_THREADS_INLINE_SIZE
+  #define DEVA_THREADS_INLINE_SIZE 0
+#endif
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace deva {
+namespace threads {
+  #if DEVA_THREADS_INLINE_SIZE
+  static_assert(DEVA_THREADS_INLINE_SIZE % 64 == 0, "tinline must be a multiple of 64.");
+  static_assert((DEVA_THREADS_INLINE_N & (DEVA_THREADS_INLINE_N-1)) == 0, "DEVA_THREADS_INLINE_N must be a power of two.");
+
+  // A message sized cell whose address is that of its payload, so freeing
+  // the message needs only its pointer.
+  struct alignas(64) inline_slot {
+    alignas(16) char buf[DEVA_THREADS_INLINE_SIZE - 16];
+    std::atomic<std::uint32_t> busy{0};
+  };
+  static_assert(sizeof(inline_slot) == DEVA_THREADS_INLINE_SIZE, "");
+
+  /* inline_ring: Slots for small messages from one writer to one reader,
+   * living in the writer's channel. Channels consume (and so free) messages
+   * in the order sent, so the writer hands slots out round robin and only
+   * has to check the next one is free. When it is not (the reader is that
+   * far behind) or the message is too big, callers fall back to the heap.
+   */
+  class inline_ring {
+    inline_slot slot_[DEVA_THREADS_INLINE_N];
+    int head_ = 0;
+
+  public:
+    template<std::size_t size, std::size_t align>
+    void* alloc() {
+      if(size > sizeof(inline_slot::buf) || align > 16)
+        return nullptr;
+
+      inline_slot *s = &slot_[head_];
+      if(s->busy.load(std::memory_order_acquire))
+        return nullptr;
+      s->busy.store(1, std::memory_order_relaxed);
+      head_ = (head_ + 1) & (DEVA_THREADS_INLINE_N-1);
+      return s->buf;
+    }
+
+    // by whichever thread the channel frees messages on
+    static void dealloc(void *m) {
+      reinterpret_cast<inline_slot*>(m)->busy.store(0, std::memory_order_release);
+    }
+  };
+  #endif
+}}
+#endif
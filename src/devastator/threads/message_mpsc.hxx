@@ -4,6 +4,8 @@
 #define _f49ebd2f7c9341ad9a3d9f865d565837
 
 #include <devastator/opnew.hxx>
+#include <devastator/threads/idle.hxx>
+#include <devastator/threads/inline_ring.hxx>
 
 #include <atomic>
 #include <cstdint>
@@ -71,6 +73,23 @@ namespace threads {
         old_tailp->store(m, std::memory_order_relaxed);
       }
     }
+
+    // enqueues `first` through `last` already linked by `r_next` at once
+    void enqueue_chain(message *first, message *last) {
+      last->r_next.store(nullptr, std::memory_order_relaxed);
+
+      if(rn > 1) {
+        auto *q = &this->tails_[threads::thread_me() % rail_n];
+        auto *old_tailp = q->tailp.exchange(&last->r_next, std::memory_order_acq_rel);
+        old_tailp->store(first, std::memory_order_relaxed);
+      }
+      else {
+        auto *q = &this->tails_[0];
+        auto *old_tailp = q->tailp.load(std::memory_order_relaxed);
+        q->tailp.store(&last->r_next, std::memory_order_release);
+        old_tailp->store(first, std::memory_order_relaxed);
+      }
+    }
   };
 
   #if DEVA_THREADS_ALLOC_EPOCH
@@ -104,6 +123,16 @@ namespace threads {
       q->store(&m->r_next, std::memory_order_release);
       tailp_old->store(m, std::memory_order_relaxed);
     }
+
+    void enqueue_chain(message *first, message *last) {
+      last->r_next.store(nullptr, std::memory_order_relaxed);
+      int e3 = threads::epoch_mod3();
+      
+      auto *q = &this->tails_[e3].tailp;
+      auto *tailp_old = q->load(std::memory_order_relaxed);
+      q->store(&last->r_next, std::memory_order_release);
+      tailp_old->store(first, std::memory_order_relaxed);
+    }
   };
   #endif
   
@@ -111,8 +140,12 @@ namespace threads {
   class channels_r: public channels_r_base<rn> {
     template<int wn, int rn1, channels_r<rn1>(*)[wn]>
     friend struct channels_w;
+
+    doorbell bell_;
     
   public:
+    doorbell& bell() { return bell_; }
+    
     template<typename Rcv>
     void receive(Rcv &&rcv, threads::progress_state &st);
     template<typename Rcv, typename Batch>
@@ -125,10 +158,26 @@ namespace threads {
       message *sent_head_ = nullptr;
       message **sent_tailp_ = &sent_head_;
     #endif
+    #if DEVA_THREADS_INLINE_SIZE
+      inline_ring rings_[wn];
+    #endif
   public:
     void connect();
     void destroy();
+
+    // Memory for a message to `w` from its inline ring, or null.
+    template<std::size_t size, std::size_t align>
+    void* alloc_inline(int w) {
+      #if DEVA_THREADS_INLINE_SIZE
+        return rings_[w].template alloc<size, align>();
+      #else
+        return nullptr;
+      #endif
+    }
+    
     void send(int w, message *m);
+    // sends the `n` messages `first` through `last` already linked by `next`
+    void send_chain(int w, message *first, message *last, int n);
     void reclaim(threads::progress_state &ps);
   };
 
@@ -145,7 +194,7 @@ namespace threads {
     while(sent_head_ != nullptr) {
       message *m = sent_head_;
       sent_head_ = m->w_next;
-      ::operator delete(m);
+      dealloc_message(m);
     }
   #endif
   }
@@ -199,7 +248,8 @@ namespace threads {
       }
     #endif
     
-    this->sent_tailp_ = mp;
+    if(*mp == nullptr) // else we stopped short and the tail is unchanged
+      this->sent_tailp_ = mp;
     ps.did_something |= did_something;
   #endif
   }
@@ -207,6 +257,7 @@ namespace threads {
   template<int wn, int rn, channels_r<rn>(*chan_r)[wn]>
   void channels_w<wn,rn,chan_r>::send(int w, message *m) {
     (*chan_r)[w].enqueue(m);
+    (*chan_r)[w].bell().ring();
     
     #if DEVA_THREADS_ALLOC_OPNEW_SYM
       m->w_next = nullptr;
@@ -215,6 +266,21 @@ namespace threads {
     #endif
   }
 
+  template<int wn, int rn, channels_r<rn>(*chan_r)[wn]>
+  void channels_w<wn,rn,chan_r>::send_chain(int w, message *first, message *last, int /*n*/) {
+    #if DEVA_THREADS_ALLOC_OPNEW_SYM
+      // the reader overwrites `r_next` as it goes so thread `w_next` first
+      for(message *m = first; m != last; m = m->next)
+        m->w_next = m->next;
+      last->w_next = nullptr;
+      *this->sent_tailp_ = first;
+      this->sent_tailp_ = &last->w_next;
+    #endif
+    
+    (*chan_r)[w].enqueue_chain(first, last);
+    (*chan_r)[w].bell().ring();
+  }
+
   //////////////////////////////////////////////////////////////////////////////
 
   template<int rn>
@@ -4,6 +4,8 @@
 #define _22a7222317264148b00b1c730d390bbd
 
 #include <devastator/opnew.hxx>
+#include <devastator/threads/idle.hxx>
+#include <devastator/threads/inline_ring.hxx>
 #include <devastator/threads/signal_slots.hxx>
 
 #include <atomic>
@@ -61,8 +63,11 @@ namespace threads {
     
     signal_slots<uint_signal_t, rn> recv_slots_;
     std::atomic<int> slot_next_{0};
+    doorbell bell_;
     
   public:
+    doorbell& bell() { return bell_; }
+    
     template<typename Rcv>
     void receive(Rcv &&rcv, threads::progress_state &st);
     template<typename Rcv, typename Batch>
@@ -94,6 +99,10 @@ namespace threads {
           #endif
         #endif
       #endif
+
+      #if DEVA_THREADS_INLINE_SIZE
+        inline_ring ring;
+      #endif
     } w_[wn];
 
     #if DEVA_THREADS_ALLOC_OPNEW_SYM
@@ -105,7 +114,20 @@ namespace threads {
     
     void connect();
     void destroy();
+
+    // Memory for a message to `id` from its inline ring, or null.
+    template<std::size_t size, std::size_t align>
+    void* alloc_inline(int id) {
+      #if DEVA_THREADS_INLINE_SIZE
+        return w_[id].ring.template alloc<size, align>();
+      #else
+        return nullptr;
+      #endif
+    }
+    
     void send(int id, message *m);
+    // sends the `n` messages `first` through `last` already linked by `next`
+    void send_chain(int id, message *first, message *last, int n);
     void reclaim(threads::progress_state &ps);
   };
 
@@ -171,6 +193,39 @@ namespace threads {
     #else
       (*chan_r)[id].recv_slots_.live.atom[w->recv_slot].store(w->recv_bump, bump_mo);
     #endif
+
+    // even when backpressured, so the reader wakes to ack
+    (*chan_r)[id].bell_.ring();
+  }
+
+  template<int wn, int rn, channels_r<rn>(*chan_r)[wn]>
+  void channels_w<wn,rn,chan_r>::send_chain(int id, message *first, message *last, int n) {
+    auto *w = &this->w_[id];
+    std::uint32_t bump_old = w->recv_bump;
+    w->recv_bump += n;
+    #if DEVA_THREADS_ALLOC_OPNEW_SYM || DEVA_THREADS_ALLOC_OPNEW_ASYM
+      w->sent_last->next = first;
+      w->sent_last = last;
+    #else
+      const int e3 = threads::epoch_mod3();
+      *w->tailp = first;
+      w->tailp = &last->next;
+      (*chan_r)[id].r_[w->recv_slot].tailp_live[e3].store(&last->next, std::memory_order_release);
+    #endif
+
+    constexpr auto bump_mo = DEVA_THREADS_ALLOC_EPOCH ? std::memory_order_relaxed : std::memory_order_release;
+    auto *slot = &(*chan_r)[id].recv_slots_.live.atom[w->recv_slot];
+
+    #if !DEVA_THREADS_ALLOC_EPOCH && DEVA_THREADS_SPSC_BITS < 32
+      // publish as much of the chain as fits under the wall, reclaim does the rest
+      if(u32_less(bump_old, w->recv_bump_wall))
+        slot->store(u32_less(w->recv_bump, w->recv_bump_wall) ? w->recv_bump : w->recv_bump_wall-1, bump_mo);
+    #else
+      (void)bump_old;
+      slot->store(w->recv_bump, bump_mo);
+    #endif
+
+    (*chan_r)[id].bell_.ring();
   }
 
   template<int wn, int rn, channels_r<rn>(*chan_r)[wn]>
@@ -186,10 +241,15 @@ namespace threads {
       
       #if DEVA_THREADS_SPSC_BITS < 32
         auto *slot = &(*chan_r)[w_id].recv_slots_.live.atom[w->recv_slot];
+        bool bumped = true;
         if(u32_less_eq(w->recv_bump_wall + acks-1, w->recv_bump))
           slot->store(w->recv_bump_wall + acks-1, std::memory_order_release);
         else if(u32_less_eq(w->recv_bump_wall, w->recv_bump))
           slot->store(w->recv_bump, std::memory_order_release);
+        else
+          bumped = false;
+        if(bumped)
+          (*chan_r)[w_id].bell_.ring();
         
         w->recv_bump_wall += acks;
       #endif
@@ -241,10 +301,15 @@ namespace threads {
           //);
 
           auto *slot = &(*chan_r)[i].recv_slots_.live.atom[w->recv_slot];
+          bool bumped = true;
           if(u32_less_eq(w->recv_bump_wall + acks-1, w->recv_bump))
             slot->store(w->recv_bump_wall + acks-1, std::memory_order_release);
           else if(u32_less_eq(w->recv_bump_wall, w->recv_bump))
             slot->store(w->recv_bump, std::memory_order_release);
+          else
+            bumped = false;
+          if(bumped)
+            (*chan_r)[i].bell_.ring();
           
           w->recv_bump_wall += acks;
 
@@ -15,6 +15,10 @@
 #include <upcxx/utility.hpp>
 
 namespace deva {
+  namespace threads {
+    class send_batch;
+  }
+  
   //////////////////////////////////////////////////////////////////////////////
   // Public API
 
@@ -58,6 +62,9 @@ namespace deva {
   template<typename Fn, typename ...Arg>
   void send_remote(int rank, Fn &&fn, Arg &&...arg);
 
+  // Batch of sends to one local rank, see `threads::send_batch`.
+  threads::send_batch send_local_batch(int rank);
+
   template<typename ProcFn>
   void bcast_procs(ProcFn &&proc_fn);
   
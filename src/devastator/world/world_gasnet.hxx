@@ -129,6 +129,11 @@ namespace deva {
     );
   }
 
+  inline threads::send_batch send_local_batch(int rank) {
+    DEVA_ASSERT(rank == ~process_me_ || (process_rank_lo_ <= rank && rank < process_rank_hi_));
+    return threads::send_batch(rank < 0 ? 0 : 1 + rank-process_rank_lo_);
+  }
+
   template<typename Fn, typename ...Arg>
   void send_remote(int rank, Fn &&fn, Arg &&...arg) {
     #define fn_on_args_expr upcxx::bind(static_cast<Fn&&>(fn), static_cast<Arg&&>(arg)...)
@@ -1,22 +1,19 @@
 #include <devastator/world//world_threads.hxx>
 
-#include <sched.h>
+namespace {
+  bool poll() {
+    deva::threads::progress_state ps;
+    do {
+      deva::threads::progress_begin(ps);
+      deva::threads::progress_stage1_reclaims(ps);
+      deva::threads::progress_stage2_recieves(ps);
+      deva::threads::progress_end(ps);
+    } while(ps.backlogged);
+    return ps.did_something;
+  }
+}
 
 void deva::progress(bool spinning) {
-  threads::progress_state ps;
-  do {
-    threads::progress_begin(ps);
-    threads::progress_stage1_reclaims(ps);
-    threads::progress_stage2_recieves(ps);
-    threads::progress_end(ps);
-  } while(ps.backlogged);
-  
-  static __thread int nothings = 0;
-  
-  if(!spinning || ps.did_something)
-    nothings = 0;
-  else if(++nothings == 10) {
-    nothings = 0;
-    sched_yield();
-  }
+  bool did_something = poll();
+  threads::progress_idle(spinning && !did_something, poll);
 }
@@ -113,6 +113,10 @@ namespace deva {
     threads::send(rank, deva::bind(static_cast<Fn&&>(fn), static_cast<Arg&&>(arg)...));
   }
   
+  inline threads::send_batch send_local_batch(int rank) {
+    return threads::send_batch(rank);
+  }
+  
   template<typename Fn, typename ...Arg>
   void send_remote(int rank, Fn &&fn, Arg &&...arg) {
     DEVA_ASSERT(0);
@@ -1,5 +1,7 @@
 #include <devastator/gvt.hxx>
 
+#include <chrono>
+#include <iostream>
 #include <random>
 #include <set>
 #include <random>
@@ -51,6 +53,12 @@ void tmain() {
   rng.seed(0xdeadbeefull*deva::rank_me());
   
   gvt::init(0, {});
+  deva::barrier();
+
+  // time to quiescence, and how the rounds spent on it went
+  auto t0 = std::chrono::steady_clock::now();
+  uint64_t round_n = 0, retry_n = 0;
+  
   gvt::coll_begin(0, {});
 
   for(int i=0; i < per_rank; i++) {
@@ -67,24 +75,40 @@ void tmain() {
     gvt::advance();
 
     //deva::say()<<"gvt "<<gvt::epoch_gvt();
+
+    if(gvt::coll_ended()) {
+      round_n += 1;
+      retry_n += gvt::coll_was_epoch() ? 0 : 1;
+    }
     
     if(~gvt::epoch_gvt() == 0)
       break;
     
-    if(gvt::coll_ended()) {
+    // with deva_gvt_pipeline > 1 collectives overlap
+    if(gvt::coll_can_begin()) {
       //if(deva::rank_me()==0) deva::say()<<"gvt="<<gvt::epoch_gvt();
       uint64_t lvt = lvts.empty() ? uint64_t(-1) : *lvts.begin();
       gvt::coll_begin(lvt, {});
     }
   }
 
+  double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
   deva::barrier();
   
   uint64_t landed = deva::reduce_sum(landed_n);
   bool success = landed == deva::rank_n*per_rank*t_end;
+
+  secs = deva::reduce_max(secs);
+  round_n = deva::reduce_max(round_n);
+  retry_n = deva::reduce_max(retry_n);
   
-  if(deva::rank_me() == 0)
+  if(deva::rank_me() == 0) {
+    std::cout<<"engine = "<<(DEVA_GVT_MATTERN ? "mattern" : "epoch")
+             <<", pipeline = "<<(DEVA_GVT_MATTERN ? 1 : gvt::pipeline)<<'\n'
+             <<"  rounds = "<<round_n<<" ("<<retry_n<<" not quiesced)\n"
+             <<"  time to quiescence = "<<secs<<" s\n";
     std::cout<<(success?"SUCCESS":"FAILURE")<<'\n';
+  }
 }
 
 int main() {
@@ -0,0 +1,182 @@
+#include <devastator/diagnostic.hxx>
+#include <devastator/world.hxx>
+#include <devastator/gvt.hxx>
+#include <devastator/pdes.hxx>
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+namespace pdes = deva::pdes;
+
+using deva::rank_n;
+using deva::rank_me;
+
+struct rng_state {
+  uint64_t a, b;
+
+  rng_state(int seed=0) {
+    a = 0x1234567812345678ull*(1+seed);
+    b = 0xdeadbeefdeadbeefull*(10+seed);
+    this->operator()();
+    this->operator()();
+  }
+
+  uint64_t operator()() {
+    uint64_t x = a;
+    uint64_t y = b;
+    a = y;
+    x ^= x << 23;
+    b = x ^ y ^ (x >> 17) ^ (y >> 26);
+    return b + y;
+  }
+};
+
+constexpr int actor_per_rank = 50;
+constexpr int actor_n = actor_per_rank*rank_n;
+constexpr int ray_n = 2*actor_n;
+constexpr double lambda = 100;
+constexpr uint64_t end_time = uint64_t(100*lambda);
+
+// Not thread_local: a migrated actor is executed by another rank of the process.
+rng_state state_cur[actor_n];
+uint64_t check[actor_n];
+
+struct event {
+  int ray;
+  int actor;
+
+  SERIALIZED_FIELDS(ray, actor);
+
+  struct reverse {
+    rng_state state_prev;
+    uint64_t check_prev;
+
+    void unexecute(pdes::event_context&, event &me) {
+      state_cur[me.actor] = state_prev;
+      check[me.actor] = check_prev;
+    }
+  };
+
+  reverse execute(pdes::execute_context &cxt) {
+    int a = this->actor;
+    rng_state &rng = state_cur[a];
+    reverse rev{rng, check[a]};
+
+    check[a] ^= check[a]>>31;
+    check[a] *= 0xdeadbeef;
+    check[a] += ray ^ 0xdeadbeef;
+
+    uint64_t dt = 1 + (uint64_t)(-lambda * std::log(1.0 - double(rng())/double(-1ull)));
+
+    // skew traffic toward low numbered actors so rank 0 is overloaded
+    int actor_to = int((rng() % actor_n)*(rng() % actor_n)/actor_n);
+
+    if(cxt.time + dt < end_time) {
+      cxt.send(
+        /*rank=*/actor_to/actor_per_rank,
+        /*cd=*/actor_to%actor_per_rank,
+        /*time=*/cxt.time + dt,
+        event{ray, actor_to}
+      );
+    }
+
+    return rev;
+  }
+};
+
+uint64_t checksum() {
+  uint64_t lacc = 0;
+  for(int cd=0; cd < actor_per_rank; cd++)
+    lacc ^= check[rank_me()*actor_per_rank + cd];
+  return deva::reduce_xor(lacc);
+}
+
+int main() {
+  int iter = 0;
+
+  auto doit = [&]() {
+    pdes::init(actor_per_rank);
+
+    int actor_lb = rank_me()*actor_per_rank;
+    for(int cd=0; cd < actor_per_rank; cd++) {
+      state_cur[actor_lb + cd] = rng_state{/*seed=*/actor_lb + cd};
+      check[actor_lb + cd] = actor_lb + cd;
+      pdes::register_state(cd, &state_cur[actor_lb + cd]);
+      pdes::register_state(cd, &check[actor_lb + cd]);
+    }
+
+    for(int ray=0; ray < ray_n; ray++) {
+      int actor = ray % actor_n;
+      if(actor/actor_per_rank == rank_me())
+        pdes::root_event(actor % actor_per_rank, ray, event{ray, actor});
+    }
+
+    // iter 0: no migration, 1: migration, 2: migration with rewindable drains,
+    // 3: cds leased within drains (`cd_steal`), 4: leased with pipelined gvt
+    bool rewindable = iter == 2;
+    int moved_n = 0;
+    uint64_t dt = end_time/8;
+
+    for(uint64_t t=dt; t < end_time; t += dt) {
+      pdes::drain(t, rewindable);
+      if(rewindable) {
+        pdes::rewind(true);
+        pdes::drain(t, true);
+        pdes::rewind(false);
+      }
+
+      if(iter == 0 || iter >= 3)
+        continue;
+
+      if(t == dt) {
+        // hand our first cd to the next rank of the process
+        int lo = deva::process_rank_lo(), hi = deva::process_rank_hi();
+        std::vector<pdes::migration> moves;
+        moves.push_back({rank_me(), 0, lo + (rank_me() - lo + 1) % (hi - lo)});
+        pdes::migrate(moves);
+        moved_n += 1;
+        DEVA_ASSERT_ALWAYS(pdes::cd_host(rank_me(), 0) == moves[0].to_rank);
+      }
+      else
+        moved_n += pdes::rebalance(0.05);
+    }
+
+    pdes::drain();
+    pdes::finalize();
+
+    moved_n = deva::reduce_sum(moved_n);
+    pdes::statistics stats = deva::reduce_sum(pdes::local_stats());
+    if(rank_me() == 0) {
+      std::cout<<"iteration "<<iter<<'\n'
+               <<"  cds migrated = "<<moved_n<<'\n'
+               <<"  cds leased = "<<stats.steal_n<<'\n'
+               <<"  commits = "<<stats.committed_n<<'\n'
+               <<"  deterministic = "<<stats.deterministic<<'\n';
+    }
+    DEVA_ASSERT_ALWAYS(iter == 0 || iter >= 3 || moved_n > 0);
+
+    uint64_t chk = checksum();
+    thread_local uint64_t chkprev = 666;
+    DEVA_ASSERT_ALWAYS(chkprev == 666 || chk == chkprev, "Checksum differs with migration.");
+    chkprev = chk;
+    if(rank_me() == 0)
+      std::cout<<"  checksum = "<<chk<<std::endl;
+  };
+
+  // leasing needs the epoch gvt engine
+  int iter_n = DEVA_GVT_MATTERN ? 3 : 5;
+  int pipeline = deva::gvt::pipeline;
+  for(iter=0; iter < iter_n; iter++) {
+    pdes::cd_steal = iter >= 3;
+    deva::gvt::pipeline = iter == 4 ? 4 : pipeline;
+    deva::run(doit);
+  }
+
+  if(deva::process_me() == 0)
+    std::cout<<"Looks good!"<<std::endl;
+  return 0;
+}
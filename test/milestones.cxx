@@ -0,0 +1,173 @@
+#include <devastator/diagnostic.hxx>
+#include <devastator/world.hxx>
+#include <devastator/pdes.hxx>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+namespace pdes = deva::pdes;
+
+using deva::rank_n;
+using deva::rank_me;
+
+struct rng_state {
+  uint64_t a, b;
+
+  rng_state(int seed=0) {
+    a = 0x1234567812345678ull*(1+seed);
+    b = 0xdeadbeefdeadbeefull*(10+seed);
+    this->operator()();
+    this->operator()();
+  }
+
+  uint64_t operator()() {
+    uint64_t x = a;
+    uint64_t y = b;
+    a = y;
+    x ^= x << 23;
+    b = x ^ y ^ (x >> 17) ^ (y >> 26);
+    return b + y;
+  }
+};
+
+constexpr int actor_per_rank = 20;
+constexpr int actor_n = actor_per_rank*rank_n;
+constexpr int ray_n = 2*actor_n;
+constexpr double lambda = 100;
+constexpr uint64_t end_time = uint64_t(100*lambda);
+constexpr uint64_t milestone_dt = end_time/32;
+
+thread_local rng_state state_cur[actor_per_rank];
+
+// iter 0: commits inline, 1: sliced (`commit_slice`), 2: sliced and offloaded
+// to the committer thread (`commit_offload`)
+int iter = 0;
+
+// committed event timestamps in commit order per rank, written by whoever
+// runs commit(), each rank reads its own only once its commits are known done
+vector<uint64_t> committed[rank_n];
+uint64_t committed_max[rank_n];
+std::atomic<int64_t> commits_on_ranks{0};
+thread_local bool on_rank = false;
+
+struct milestone_seen {
+  uint64_t t;
+  size_t committed_n;
+};
+thread_local vector<milestone_seen> seen;
+
+struct event {
+  int actor;
+
+  SERIALIZED_FIELDS(actor);
+
+  struct reverse {
+    rng_state state_prev;
+
+    void unexecute(pdes::event_context&, event &me) {
+      state_cur[me.actor % actor_per_rank] = state_prev;
+    }
+
+    void commit(pdes::event_context &cxt, event &me) {
+      if(on_rank)
+        commits_on_ranks.fetch_add(1, std::memory_order_relaxed);
+      int r = me.actor/actor_per_rank;
+      committed[r].push_back(cxt.time);
+      committed_max[r] = std::max(committed_max[r], cxt.time);
+    }
+  };
+
+  reverse execute(pdes::execute_context &cxt) {
+    rng_state &rng = state_cur[actor % actor_per_rank];
+    reverse rev{rng};
+
+    uint64_t dt = 1 + (uint64_t)(-lambda * std::log(1.0 - double(rng())/double(-1ull)));
+    int actor_to = rng() % actor_n;
+
+    if(cxt.time + dt < end_time)
+      cxt.send(actor_to/actor_per_rank, actor_to%actor_per_rank, cxt.time + dt, event{actor_to});
+
+    return rev;
+  }
+};
+
+// each milestone registers the next one from within its callback
+void on_milestone(uint64_t t) {
+  vector<uint64_t> const &mine = committed[rank_me()];
+  // the committer may be running later commits of ours concurrently
+  if(!pdes::commit_offload)
+    DEVA_ASSERT_ALWAYS(mine.empty() || committed_max[rank_me()] < t, "Event at "<<committed_max[rank_me()]<<" committed before milestone "<<t);
+  DEVA_ASSERT_ALWAYS(seen.empty() || seen.back().t < t);
+  seen.push_back({t, mine.size()});
+
+  if(t + milestone_dt < end_time)
+    pdes::at_gvt(t + milestone_dt, on_milestone);
+}
+
+int main() {
+  auto doit = []() {
+    on_rank = true;
+    seen.clear();
+    pdes::init(actor_per_rank);
+
+    for(int cd=0; cd < actor_per_rank; cd++) {
+      state_cur[cd] = rng_state{/*seed=*/rank_me()*actor_per_rank + cd};
+      pdes::register_state(cd, &state_cur[cd]);
+    }
+
+    for(int ray=0; ray < ray_n; ray++) {
+      int actor = ray % actor_n;
+      if(actor/actor_per_rank == rank_me())
+        pdes::root_event(actor % actor_per_rank, ray, event{actor});
+    }
+
+    pdes::at_gvt(milestone_dt, on_milestone);
+
+    // a milestone reached in the first drain but registered late
+    bool late_fired = false;
+
+    pdes::drain(end_time/2);
+    pdes::at_gvt(end_time/4, [&](uint64_t) { late_fired = true; });
+    pdes::drain();
+    pdes::finalize();
+
+    DEVA_ASSERT_ALWAYS(late_fired);
+    DEVA_ASSERT_ALWAYS(seen.size() == (end_time-1)/milestone_dt);
+
+    // each milestone saw exactly the events before it committed
+    vector<uint64_t> const &mine = committed[rank_me()];
+    for(milestone_seen m: seen) {
+      size_t n = std::count_if(mine.begin(), mine.end(), [&](uint64_t t) { return t < m.t; });
+      DEVA_ASSERT_ALWAYS(n == m.committed_n, "Milestone "<<m.t<<" saw "<<m.committed_n<<" commits, expected "<<n);
+    }
+
+    pdes::statistics stats = deva::reduce_sum(pdes::local_stats());
+    uint64_t commit_n = deva::reduce_sum(uint64_t(mine.size()));
+    DEVA_ASSERT_ALWAYS(commit_n == stats.committed_n);
+    DEVA_ASSERT_ALWAYS(iter != 2 || commits_on_ranks.load() == 0);
+
+    if(rank_me() == 0)
+      std::cout<<"iteration "<<iter<<": milestones = "<<seen.size()<<", commits = "<<commit_n<<std::endl;
+  };
+
+  for(iter=0; iter < 3; iter++) {
+    pdes::commit_slice = iter >= 1 ? 16 : 0;
+    pdes::commit_offload = iter == 2;
+    for(int r=0; r < rank_n; r++) {
+      committed[r].clear();
+      committed_max[r] = 0;
+    }
+    commits_on_ranks.store(0);
+    deva::run(doit);
+  }
+
+  if(deva::process_me() == 0)
+    std::cout<<"Looks good!"<<std::endl;
+  return 0;
+}
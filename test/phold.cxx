@@ -48,6 +48,8 @@ constexpr int actor_per_rank = (actor_n + rank_n-1)/rank_n;
 thread_local rng_state state_cur[actor_per_rank];
 thread_local uint64_t check[actor_per_rank];
 
+bool use_save; // reverse via execute_context::save() instead of `reverse`
+
 struct event {
   int ray;
   int actor;
@@ -82,6 +84,7 @@ struct event {
     
     void unexecute(pdes::event_context&, event &me) {
       //say() << "unexecute "<<me.actor;
+      if(use_save) return; // already restored by runtime
       int a = me.actor % actor_per_rank;
       state_cur[a] = state_prev;
       check[a] = check_prev;  
@@ -103,6 +106,11 @@ struct event {
     rng_state &rng = state_cur[a];
     rng_state state_prev = rng;
 
+    if(use_save) {
+      cxt.save(rng);
+      cxt.save(check[a]);
+    }
+
     auto check_prev = check[a];
     check[a] ^= check[a]>>31;
     check[a] *= 0xdeadbeef;
@@ -204,6 +212,7 @@ int main() {
     pdes::statistics stats = deva::reduce_sum(pdes::local_stats());
     if(deva::rank_me()==0) {
       std::cout<<"rewind enabled = "<<(iter%2 == 0)<<'\n'
+               <<"  state saving = "<<use_save<<'\n'
                <<"  events = "<<stats.executed_n<<'\n'
                <<"  commits = "<<stats.committed_n<<'\n'
                <<"  deterministic = "<<stats.deterministic<<'\n';
@@ -218,8 +227,10 @@ int main() {
       std::cout<<"  checksum = "<<chk<<std::endl;
   };
 
-  for(iter=0; iter < 4; iter++)
+  for(iter=0; iter < 4; iter++) {
+    use_save = iter >= 2;
     deva::run(doit);
+  }
   
   if(deva::process_me() == 0)
     std::cout<<"Looks good!"<<std::endl;
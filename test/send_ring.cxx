@@ -28,6 +28,35 @@ void bounce(int round) {
   }
 }
 
+// batches of growing size (past the spsc signal wall) to our successor, whose
+// messages must arrive in order and all be seen
+constexpr int batch_rounds = 40;
+__thread int batch_got = 0;
+
+void batches() {
+  int seq = 0;
+  for(int r=0; r < batch_rounds; r++) {
+    auto b = deva::send_local_batch((rank_me()+1)%rank_n);
+    for(int i=0; i < 1 + 13*r; i++) {
+      b.send([=]() {
+        // talloc=epoch is only fifo within an epoch
+        DEVA_ASSERT_ALWAYS(DEVA_THREADS_ALLOC_EPOCH || seq == batch_got, "seq="<<seq<<" got="<<batch_got);
+        batch_got += 1;
+      });
+      seq += 1;
+    }
+    if(r % 2 == 0)
+      b.flush(); // else on destruction
+    deva::progress();
+  }
+
+  while(batch_got != seq)
+    deva::progress();
+
+  // our successor may still need us to progress to see all of ours
+  deva::barrier();
+}
+
 int main() {
   auto doit = []() {
     if(rank_me() == 0)
@@ -35,6 +64,9 @@ int main() {
 
     while(!done)
       deva::progress();
+
+    deva::barrier();
+    batches();
     
     deva::say()<<"leaving";
 